@@ -26,6 +26,7 @@ Chunk::Chunk()
   : version(0)
   , highest(INT_MIN)
   , lowest(INT_MAX)
+  , parsed(false)
   , loaded(false)
   , rendering(false)
 {}
@@ -262,7 +263,7 @@ void Chunk::loadLevelTag(const Tag * level) {
   // todo: use highmap from stored NBT data
   findHighestBlock();
 
-  loaded = true; // needs to be at the end!
+  parsed = true;  // loaded by finishLoading()
 }
 
 
@@ -325,7 +326,7 @@ void Chunk::loadCliffsCaves(const NBT &nbt) {
   // todo: use highmap from stored NBT data
   findHighestBlock();
 
-  loaded = true; // needs to be at the end!
+  parsed = true;  // loaded by finishLoading()
 }
 
 
@@ -344,6 +345,10 @@ void Chunk::loadEntities(const NBT &nbt) {
   }
 }
 
+void Chunk::finishLoading() {
+  loaded = parsed;  // needs to be at the end!
+}
+
 
 // supported DataVersions:
 //    0 = 1.8 and below
@@ -506,6 +511,7 @@ void Chunk::loadSection_decodeBlockPalette(ChunkSection * cs, const Tag * palett
     }
     // store hash of found variant
     cs->blockPalette[j].hid  = hid;
+    cs->blockPalette[j].cid  = bi.getCompactId(hid);
   }
 }
 
@@ -515,6 +521,7 @@ void Chunk::loadSection_createDummyPalette(ChunkSection *cs) {
   cs->blockPalette = new PaletteEntry[1];
   cs->blockPalette[0].name = "minecraft:air";
   cs->blockPalette[0].hid  = 0;
+  cs->blockPalette[0].cid  = 0;
 }
 
 
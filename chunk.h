@@ -28,6 +28,11 @@ class ChunkSection {
   quint8 getBlockLight(int x, int y, int z) const;
   quint8 getBlockLight(int offset, int y) const;
   quint8 getBlockLight(int offset) const;
+  // compact render ID of one Block, index is x + 16*z + 256*(y & 0x0f)
+  quint16 getCompactId(int index) const {
+    quint16 blockid = blocks[index];
+    return blockPalette[(blockid < blockPaletteLength) ? blockid : 0].cid;
+  }
 
   PaletteEntry *blockPalette;
   int        blockPaletteLength;
@@ -40,6 +45,9 @@ class ChunkSection {
 };
 
 
+class SpawnMask;
+class SurfaceIndex;
+
 class Chunk : public QObject {
   Q_OBJECT
 
@@ -48,10 +56,13 @@ class Chunk : public QObject {
   ~Chunk();
   void load(const NBT &nbt);
   void loadEntities(const NBT &nbt);
+  // all NBT data is parsed, flag Chunk as loaded for use by other threads
+  void finishLoading();
 
   // public getters to read-only access internal data
   int getChunkX() const { return chunkX; }
   int getChunkZ() const { return chunkZ; }
+  int getVersion() const { return version; }
   const uchar * getImage() const { return image; }
   int  getHighest() const { return highest; }
   int  getLowest() const  { return lowest; }
@@ -80,6 +91,7 @@ class Chunk : public QObject {
   int  lowest;
   int  renderedAt;
   int  renderedFlags;
+  bool parsed;   // Chunk data found, loaded once Entities are parsed as well
   bool loaded;
   bool rendering;
 
@@ -88,9 +100,16 @@ class Chunk : public QObject {
   uchar  image[16 * 16 * 4];  // cached render: RGBA for 16*16 Blocks
   short  depth[16 * 16];      // cached depth map to create shadow
   EntityMap entities;
+  QSharedPointer<SurfaceIndex> surfaceIndex;  // built on demand when depth changes
+  QSharedPointer<SpawnMask>    spawnMask;     // built per Section on demand while rendering
+  QMutex renderMutex;  // guards surfaceIndex and spawnMask, shared by concurrent renders
   friend class MapView;
   friend class ChunkRenderer;
   friend class ChunkCache;
+  friend class TileCache;
+  friend class CompressedChunk;
+  friend class ChunkSpill;
+  friend class ViewComposer;
 
  private:
   void findHighestBlock();
@@ -1,7 +1,11 @@
 /** Copyright (c) 2013, Sean Kasun */
 
+#include <QSettings>
+#include <QtConcurrent/QtConcurrent>
+
 #include "chunkcache.h"
 #include "chunkloader.h"
+#include "renderqueue.h"
 
 
 #if defined(__unix__) || defined(__unix) || defined(unix)
@@ -10,20 +14,48 @@
 #include <windows.h>
 #endif
 
-ChunkCache::ChunkCache() {
+CachedChunk::CachedChunk(ChunkCache *owner, const ChunkID &id, const QSharedPointer<Chunk> &chunk)
+  : QSharedPointer<Chunk>(chunk)
+  , owner(owner)
+  , id(id)
+{}
+
+CachedChunk::~CachedChunk() {
+  // called by QCache during eviction, Cache mutex is already locked
+  owner->demote(id, *this);
+}
+
+ColdChunk::ColdChunk(ChunkCache *owner, const ChunkID &id, CompressedChunk *chunk)
+  : QSharedPointer<CompressedChunk>(chunk)
+  , owner(owner)
+  , id(id)
+{}
+
+ColdChunk::~ColdChunk() {
+  // called by QCache during eviction, Cache mutex is already locked
+  // (promoted Chunks are cleared before)
+  owner->demote(id, *this);
+}
+
+
+ChunkCache::ChunkCache()
+  : demoteEvicted(true)
+  , compressing(false)
+{
   const int sizeChunkMax     = sizeof(Chunk) + 16 * sizeof(ChunkSection);  // all sections contain Blocks
   const int sizeChunkTypical = sizeof(Chunk) + 6 * sizeof(ChunkSection);   // world generation is average Y=64..128
 
   // default: 10% more than 1920x1200 blocks
   int chunks = 10000;
   maxcache = chunks;
+  quint64 available = quint64(chunks) * sizeChunkTypical;
 
   // try to determine available pysical memory based on operation system we are running on
 #if defined(__unix__) || defined(__unix) || defined(unix)
 #ifdef _SC_AVPHYS_PAGES
   auto pages = sysconf(_SC_AVPHYS_PAGES);
   auto page_size = sysconf(_SC_PAGE_SIZE);
-  quint64 available = (pages*page_size);
+  available = (pages*page_size);
   chunks   = available / sizeChunkMax;
   maxcache = available / sizeChunkTypical;  // most chunks are less filled with sections
 #endif
@@ -31,10 +63,15 @@ ChunkCache::ChunkCache() {
   MEMORYSTATUSEX status;
   status.dwLength = sizeof(status);
   GlobalMemoryStatusEx(&status);
-  DWORDLONG available = qMin(status.ullAvailPhys, status.ullAvailVirtual);
+  available = qMin(status.ullAvailPhys, status.ullAvailVirtual);
   chunks   = available / sizeChunkMax;
   maxcache = available / sizeChunkTypical;  // most chunks are less filled with sections
 #endif
+  // cold Chunks are compressed, a quarter of the memory is spent on them
+  // and taken from the share of the Cache
+  chunks   -= chunks   / 4;
+  maxcache -= maxcache / 4;
+  coldCache.setMaxCost(available / (4 * 1024));
   // we start the Cache based on worst case calculation
   cache.setMaxCost(chunks);
 
@@ -42,12 +79,25 @@ ChunkCache::ChunkCache() {
   // as this contains disk access, use less than number of cores
   int tmax = loaderThreadPool.maxThreadCount();
   loaderThreadPool.setMaxThreadCount(tmax / 2);
+  // evicted Chunks are compressed in order, one after the other
+  compressorPool.setMaxThreadCount(1);
 
   qRegisterMetaType<QSharedPointer<GeneratedStructure>>("QSharedPointer<GeneratedStructure>");
 }
 
 ChunkCache::~ChunkCache() {
   loaderThreadPool.waitForDone();
+  {
+    QMutexLocker guard(&mutex);
+    demoteEvicted = false;
+    evicted.clear();
+    spilling.clear();
+  }
+  compressorPool.waitForDone();
+
+  QMutexLocker guard(&mutex);
+  cache.clear();
+  coldCache.clear();
 }
 
 ChunkCache& ChunkCache::Instance() {
@@ -56,16 +106,36 @@ ChunkCache& ChunkCache::Instance() {
 }
 
 void ChunkCache::clear() {
-  QThreadPool::globalInstance()->waitForDone();
+  // no renders of Chunks from the old world are needed anymore
+  RenderQueue::Instance().cancelAll();
+  RenderQueue::Instance().waitForDone();
+
+  // drop Chunks waiting for compression, wait for the running one
+  {
+    QMutexLocker guard(&mutex);
+    demoteEvicted = false;
+    evicted.clear();
+    spilling.clear();
+  }
+  compressorPool.waitForDone();
 
   QMutexLocker guard(&mutex);
   cache.clear();
+  coldCache.clear();
+  spill.clear();
+  demoteEvicted = true;
 }
 
 void ChunkCache::setPath(QString path) {
   if (this->path != path)
     clear();
   this->path = path;
+
+  // optional disk tier, (re)created for every world
+  QSettings settings;
+  QMutexLocker guard(&mutex);
+  spill.setup(settings.value("spillchunks", false).toBool(),
+              settings.value("spillsize", 4096).toInt());
 }
 QString ChunkCache::getPath() const {
   return path;
@@ -83,6 +153,22 @@ int ChunkCache::getMemoryMax() const {
   return maxcache;
 }
 
+int ChunkCache::getCompressedUsage() const {
+  return coldCache.totalCost();
+}
+
+int ChunkCache::getCompressedMax() const {
+  return coldCache.maxCost();
+}
+
+int ChunkCache::getSpillUsage() const {
+  return spill.getUsage();
+}
+
+int ChunkCache::getSpillMax() const {
+  return spill.getMax();
+}
+
 QSharedPointer<Chunk> ChunkCache::fetchCached(int cx, int cz) {
   // try to get Chunk from Cache
   ChunkID id(cx, cz);
@@ -100,10 +186,27 @@ CacheState ChunkCache::getCached(const ChunkID &id, QSharedPointer<Chunk> &chunk
 
 CacheState ChunkCache::getCached_intern(const ChunkID &id, QSharedPointer<Chunk> &chunk_out)
 {
-  QSharedPointer<Chunk> * p_chunk = cache[id];   // const operation
+  CachedChunk * p_chunk = cache[id];   // const operation
   if (!p_chunk)
   {
-    return CacheState::uncached;
+    // still waiting for compression, or promote from compressed tier
+    ColdChunk *cold = NULL;
+    if (evicted.contains(id)) {
+      chunk_out = evicted.take(id);
+    } else if ((cold = coldCache.take(id))) {
+      chunk_out = (*cold)->restore();
+      cold->clear();  // not evicted
+      delete cold;
+    } else if (spilling.contains(id)) {
+      chunk_out = spilling.take(id)->restore();
+    } else {
+      // promote from disk tier
+      chunk_out = spill.load(id);
+      if (!chunk_out)
+        return CacheState::uncached;
+    }
+    cache.insert(id, new CachedChunk(this, id, chunk_out));
+    return CacheState::cached;
   }
 
   chunk_out = (*p_chunk);
@@ -128,7 +231,23 @@ QSharedPointer<Chunk> ChunkCache::fetch(int cx, int cz) {
     return QSharedPointer<Chunk>(); // already loading, return nullptr
 
   // launch background process to load this chunk
-  QSharedPointer<Chunk> * p_chunk = new QSharedPointer<Chunk>(new Chunk());
+  startLoading(id, 0);
+  return QSharedPointer<Chunk>(NULL);
+}
+
+bool ChunkCache::prefetch(int cx, int cz) {
+  ChunkID id(cx, cz);
+  QSharedPointer<Chunk> chunk;
+  if (getCached(id, chunk) != CacheState::uncached)
+    return false;  // already cached or loading
+
+  // queued behind all loading requests for visible Chunks
+  startLoading(id, -1);
+  return true;
+}
+
+void ChunkCache::startLoading(const ChunkID &id, int priority) {
+  CachedChunk * p_chunk = new CachedChunk(this, id, QSharedPointer<Chunk>(new Chunk()));
   connect(p_chunk->data(), SIGNAL(structureFound(QSharedPointer<GeneratedStructure>)),
           this,            SLOT  (routeStructure(QSharedPointer<GeneratedStructure>)));
 
@@ -136,11 +255,10 @@ QSharedPointer<Chunk> ChunkCache::fetch(int cx, int cz) {
     QMutexLocker guard(&mutex);
     cache.insert(id, p_chunk);    // non-const operation !
   }
-  ChunkLoader *loader = new ChunkLoader(path, cx, cz);
+  ChunkLoader *loader = new ChunkLoader(path, id.getX(), id.getZ());
   connect(loader, SIGNAL(loaded(int, int)),
           this,   SLOT(gotChunk(int, int)));
-  loaderThreadPool.start(loader);
-  return QSharedPointer<Chunk>(NULL);
+  loaderThreadPool.start(loader, priority);
 }
 
 QSharedPointer<Chunk> ChunkCache::getChunkSynchronously(const ChunkID& id)
@@ -167,12 +285,87 @@ QSharedPointer<Chunk> ChunkCache::getChunkSynchronously(const ChunkID& id)
   if (hasFreeSpaceInCache && chunk->loaded) // only cache in case of lot of memory to not degrade drawing performance
   {
     QMutexLocker guard(&mutex);
-    cache.insert(id, new QSharedPointer<Chunk>(chunk));
+    cache.insert(id, new CachedChunk(this, id, chunk));
   }
 
   return chunk;
 }
 
+// called with locked mutex, when a Chunk leaves the Cache
+void ChunkCache::demote(const ChunkID &id, const QSharedPointer<Chunk> &chunk) {
+  if (!demoteEvicted || !chunk || !chunk->loaded)
+    return;  // nothing to keep (yet)
+
+  // compression is too slow to be done while the Cache is locked
+  evicted.insert(id, chunk);
+  startCompressor();
+}
+
+// called with locked mutex, when a Chunk leaves the compressed tier
+void ChunkCache::demote(const ChunkID &id, const QSharedPointer<CompressedChunk> &chunk) {
+  if (!demoteEvicted || !chunk || !spill.isEnabled())
+    return;
+
+  spilling.insert(id, chunk);
+  startCompressor();
+}
+
+// called with locked mutex
+void ChunkCache::startCompressor() {
+  if (!compressing) {
+    compressing = true;
+    QtConcurrent::run(&compressorPool, [this]() { compressEvicted(); });
+  }
+}
+
+// move evicted Chunks down into the compressed and disk tier,
+// runs on the compressor thread
+void ChunkCache::compressEvicted() {
+  forever {
+    // Chunks stay in the queue while being compressed, so they can still be fetched
+    QHash<ChunkID, QSharedPointer<Chunk>> batch;
+    QHash<ChunkID, QSharedPointer<CompressedChunk>> spillBatch;
+    {
+      QMutexLocker guard(&mutex);
+      if (evicted.isEmpty() && spilling.isEmpty()) {
+        compressing = false;
+        return;
+      }
+      batch = evicted;
+      spillBatch = spilling;
+    }
+
+    // decompress once more and write to disk, without locking the Cache
+    for (auto it = spillBatch.constBegin(); it != spillBatch.constEnd(); ++it) {
+      QSharedPointer<Chunk> chunk = (*it)->restore();
+      if (chunk)
+        spill.store(it.key(), *chunk);
+      // skip Chunks fetched again meanwhile, or dropped by clear()
+      QMutexLocker guard(&mutex);
+      auto queued = spilling.find(it.key());
+      if ((queued != spilling.end()) && (*queued == *it))
+        spilling.erase(queued);
+    }
+
+    QHash<ChunkID, CompressedChunk*> compressed;
+    for (auto it = batch.constBegin(); it != batch.constEnd(); ++it)
+      compressed.insert(it.key(), new CompressedChunk(**it));
+
+    QMutexLocker guard(&mutex);
+    for (auto it = compressed.constBegin(); it != compressed.constEnd(); ++it) {
+      // skip Chunks fetched again meanwhile, or dropped by clear()
+      auto queued = evicted.find(it.key());
+      if ((queued == evicted.end()) || (*queued != batch.value(it.key()))) {
+        delete *it;
+        continue;
+      }
+      evicted.erase(queued);
+      coldCache.insert(it.key(), new ColdChunk(this, it.key(), *it),
+                       std::max(1, (*it)->size() / 1024));
+    }
+  }
+}
+
 void ChunkCache::gotChunk(int cx, int cz) {
   emit chunkLoaded(cx, cz);
 }
@@ -4,8 +4,12 @@
 
 #include <QObject>
 #include <QCache>
+#include <QHash>
+#include <QThreadPool>
 #include "chunk.h"
 #include "chunkid.h"
+#include "compressedchunk.h"
+#include "chunkspill.h"
 
 enum class CacheState {
   uncached,
@@ -13,6 +17,30 @@ enum class CacheState {
   cached // still can be nullptr when empty
 };
 
+class ChunkCache;
+
+// entry of the Cache, evicted Chunks are moved into the compressed tier
+class CachedChunk : public QSharedPointer<Chunk> {
+ public:
+  CachedChunk(ChunkCache *owner, const ChunkID &id, const QSharedPointer<Chunk> &chunk);
+  ~CachedChunk();
+
+ private:
+  ChunkCache *owner;
+  ChunkID     id;
+};
+
+// entry of the compressed tier, evicted Chunks are moved into the disk tier
+class ColdChunk : public QSharedPointer<CompressedChunk> {
+ public:
+  ColdChunk(ChunkCache *owner, const ChunkID &id, CompressedChunk *chunk);
+  ~ColdChunk();
+
+ private:
+  ChunkCache *owner;
+  ChunkID     id;
+};
+
 class ChunkCache : public QObject {
   Q_OBJECT
 
@@ -31,12 +59,17 @@ class ChunkCache : public QObject {
   void setPath(QString path);
   QString getPath() const;
   QSharedPointer<Chunk> fetch(int cx, int cz);         // fetch Chunk and load when not found
+  bool prefetch(int cx, int cz);                       // queue low priority loading of Chunk when not found
   QSharedPointer<Chunk> fetchCached(int cx, int cz);   // fetch Chunk only if cached
   CacheState getCached(const ChunkID& id, QSharedPointer<Chunk>& chunk_out);    // fetch Chunk only if cached, can tell if just not loaded or empty
   QSharedPointer<Chunk> getChunkSynchronously(const ChunkID& id);         // get chunk if cached directly, or load it in a synchronous blocking way
   int getCacheUsage() const;
   int getCacheMax() const;
   int getMemoryMax() const;
+  int getCompressedUsage() const;   // in KB
+  int getCompressedMax() const;     // in KB
+  int getSpillUsage() const;        // in MB
+  int getSpillMax() const;          // in MB
 
  signals:
   void chunkLoaded(int cx, int cz);
@@ -51,12 +84,27 @@ class ChunkCache : public QObject {
 
  private:
   QString path;                                   // path to folder with region files
-  QCache<ChunkID, QSharedPointer<Chunk>> cache;   // real Cache
+  QCache<ChunkID, CachedChunk> cache;             // real Cache
+  QCache<ChunkID, ColdChunk> coldCache;           // second tier with cold Chunks, cost in KB
+  ChunkSpill spill;                               // optional third tier on disk
+  bool demoteEvicted;                             // move Chunks evicted from Cache into second tier
+  QHash<ChunkID, QSharedPointer<Chunk>> evicted;  // waiting for compression into second tier
+  QHash<ChunkID, QSharedPointer<CompressedChunk>> spilling;  // evicted from second tier,
+                                                             // waiting for the disk tier
+  bool compressing;                               // compression of evicted Chunks is running
   QMutex mutex;                                   // Mutex for accessing the Cache
   int maxcache;                                   // number of Chunks that fit into memory
   QThreadPool loaderThreadPool;                   // extra thread pool for loading
+  QThreadPool compressorPool;                     // moves evicted Chunks down, off the Cache mutex
 
   CacheState getCached_intern(const ChunkID& id, QSharedPointer<Chunk>& chunk_out);
+  void startLoading(const ChunkID& id, int priority);
+  void demote(const ChunkID& id, const QSharedPointer<Chunk>& chunk);
+  void demote(const ChunkID& id, const QSharedPointer<CompressedChunk>& chunk);
+  void startCompressor();
+  void compressEvicted();
+  friend class CachedChunk;
+  friend class ColdChunk;
 };
 
 #endif  // CHUNKCACHE_H_
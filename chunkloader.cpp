@@ -41,6 +41,8 @@ bool ChunkLoader::loadNbt(QString path, int cx, int cz, QSharedPointer<Chunk> ch
   filename = path + "/entities/r." + QString::number(rx) + "." + QString::number(rz) + ".mca";
   loadNbtHelper(filename, cx, cz, chunk, ChunkLoader::SEPARATED_ENTITIES);
 
+  // Entities may come from a separate file, other threads wait for both
+  chunk->finishLoading();
   return result;
 }
 
@@ -0,0 +1,151 @@
+#include <cmath>
+#include <algorithm>
+
+#include "chunkprefetcher.h"
+#include "chunkcache.h"
+
+static const int    defaultBudget   = 256;   // outstanding prefetch requests
+static const int    maxAge          = 120;   // redraws until a prefetched Chunk counts as wasted
+static const qint64 panTimeout      = 500;   // ms after last pan input the velocity is still valid
+static const qint64 zoomTimeout     = 1000;  // ms after last zoom out the ring is still prefetched
+static const double lookaheadEvents = 8.0;   // predict that many pan input events ahead
+
+ChunkPrefetcher::ChunkPrefetcher(ChunkCache &cache)
+  : cache(cache)
+  , budget(defaultBudget)
+  , generation(0)
+  , vx(0.0), vz(0.0)
+  , hits(0), misses(0), wasted(0)
+{}
+
+void ChunkPrefetcher::setBudget(int chunks) {
+  budget = std::max(0, chunks);
+}
+
+int ChunkPrefetcher::getBudget() const {
+  return budget;
+}
+
+void ChunkPrefetcher::reset() {
+  pending.clear();
+  generation = 0;
+  vx = vz = 0.0;
+  lastPan.invalidate();
+  lastZoomOut.invalidate();
+  hits = misses = wasted = 0;
+}
+
+void ChunkPrefetcher::trackPan(double dx, double dz) {
+  if (!lastPan.isValid() || lastPan.hasExpired(panTimeout)) {
+    // start of a new pan movement
+    vx = dx;
+    vz = dz;
+  } else {
+    // smooth velocity over the last input events
+    vx = 0.5 * (vx + dx);
+    vz = 0.5 * (vz + dz);
+  }
+  lastPan.start();
+}
+
+void ChunkPrefetcher::trackZoom(double steps) {
+  if (steps < 0)
+    lastZoomOut.start();
+  else if (steps > 0)
+    lastZoomOut.invalidate();  // zooming in never exposes new Chunks
+}
+
+void ChunkPrefetcher::markVisible(int cx, int cz) {
+  ChunkID id(cx, cz);
+  if (pending.remove(id)) {
+    hits++;
+    return;
+  }
+  QSharedPointer<Chunk> chunk;
+  if (cache.getCached(id, chunk) == CacheState::uncached)
+    misses++;
+}
+
+void ChunkPrefetcher::prefetch(const QRect &visible) {
+  generation++;
+
+  // drop requests that did not become visible in time
+  for (auto it = pending.begin(); it != pending.end(); ) {
+    if (generation - it.value() > maxAge) {
+      wasted++;
+      it = pending.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if ((budget <= 0) || visible.isEmpty())
+    return;
+  // never push visible Chunks out of the Cache
+  if (cache.getCacheUsage() >= 0.9 * cache.getCacheMax())
+    return;
+
+  // strips in pan direction, nearest first
+  if (lastPan.isValid() && !lastPan.hasExpired(panTimeout)) {
+    const int maxAhead = std::max(visible.width(), visible.height()) / 2;
+    const int aheadX = std::min(maxAhead, int(ceil(fabs(vx) * lookaheadEvents / 16)));
+    const int aheadZ = std::min(maxAhead, int(ceil(fabs(vz) * lookaheadEvents / 16)));
+    QRect inner = visible;
+    for (int d = 1; d <= std::max(aheadX, aheadZ); d++) {
+      QRect outer = inner;
+      if (d <= aheadX) {
+        if (vx > 0) outer.setRight(outer.right() + 1);
+        else        outer.setLeft (outer.left()  - 1);
+      }
+      if (d <= aheadZ) {
+        if (vz > 0) outer.setBottom(outer.bottom() + 1);
+        else        outer.setTop   (outer.top()    - 1);
+      }
+      if (!requestGrowth(inner, outer))
+        return;  // budget exhausted
+      inner = outer;
+    }
+  }
+
+  // ring around the view after zooming out, nearest first
+  if (lastZoomOut.isValid() && !lastZoomOut.hasExpired(zoomTimeout)) {
+    // next zoom level shows up to twice the current extent
+    const int ring = (std::max(visible.width(), visible.height()) + 1) / 2;
+    QRect inner = visible;
+    for (int d = 1; d <= ring; d++) {
+      QRect outer = inner.adjusted(-1, -1, 1, 1);
+      if (!requestGrowth(inner, outer))
+        return;  // budget exhausted
+      inner = outer;
+    }
+  }
+}
+
+// request all Chunks inside outer but not inside inner
+bool ChunkPrefetcher::requestGrowth(const QRect &inner, const QRect &outer) {
+  // full rows above and below
+  for (int cz = outer.top(); cz < inner.top(); cz++)
+    for (int cx = outer.left(); cx <= outer.right(); cx++)
+      if (!request(cx, cz)) return false;
+  for (int cz = inner.bottom() + 1; cz <= outer.bottom(); cz++)
+    for (int cx = outer.left(); cx <= outer.right(); cx++)
+      if (!request(cx, cz)) return false;
+  // partial columns left and right
+  for (int cx = outer.left(); cx < inner.left(); cx++)
+    for (int cz = inner.top(); cz <= inner.bottom(); cz++)
+      if (!request(cx, cz)) return false;
+  for (int cx = inner.right() + 1; cx <= outer.right(); cx++)
+    for (int cz = inner.top(); cz <= inner.bottom(); cz++)
+      if (!request(cx, cz)) return false;
+  return true;
+}
+
+bool ChunkPrefetcher::request(int cx, int cz) {
+  if (pending.size() >= budget)
+    return false;
+
+  ChunkID id(cx, cz);
+  if (!pending.contains(id) && cache.prefetch(cx, cz))
+    pending.insert(id, generation);
+  return true;
+}
@@ -0,0 +1,53 @@
+#ifndef CHUNKPREFETCHER_H_
+#define CHUNKPREFETCHER_H_
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRect>
+#include "chunkid.h"
+
+class ChunkCache;
+
+// Predicts which Chunks become visible next and queues them for loading
+// with low priority. Prediction is based on the recent pan velocity and
+// on the zoom direction (zooming out exposes a ring around the view).
+class ChunkPrefetcher {
+ public:
+  explicit ChunkPrefetcher(ChunkCache &cache);
+
+  void setBudget(int chunks);           // maximum number of outstanding prefetch requests
+  int  getBudget() const;
+  void reset();                         // forget all pending requests and counters
+
+  // input tracking
+  void trackPan(double dx, double dz);  // view moved by dx,dz Blocks
+  void trackZoom(double steps);         // zoom changed, negative steps zoom out
+
+  // called during redraw with Chunk coordinates
+  void markVisible(int cx, int cz);     // count hit/miss for one visible Chunk
+  void prefetch(const QRect &visible);  // queue Chunks likely to become visible next
+
+  // statistics for tuning
+  quint64 getHits() const   { return hits; }    // prefetched Chunk became visible
+  quint64 getMisses() const { return misses; }  // visible Chunk had to be loaded on demand
+  quint64 getWasted() const { return wasted; }  // prefetched Chunk never became visible
+
+ private:
+  bool requestGrowth(const QRect &inner, const QRect &outer);
+  bool request(int cx, int cz);
+
+  ChunkCache &cache;
+  int budget;
+  int generation;                       // counts prefetch() calls to age pending requests
+  QHash<ChunkID, int> pending;          // prefetched Chunks not yet visible -> generation
+
+  double vx, vz;                        // smoothed pan velocity in Blocks per input event
+  QElapsedTimer lastPan;
+  QElapsedTimer lastZoomOut;
+
+  quint64 hits;
+  quint64 misses;
+  quint64 wasted;
+};
+
+#endif  // CHUNKPREFETCHER_H_
@@ -1,255 +1,481 @@
 /** Copyright (c) 2019, EtlamGit */
 
+#include <QVarLengthArray>
+#include <algorithm>
+#include <climits>
+
 #include "chunk.h"
 #include "chunkrenderer.h"
 #include "chunkcache.h"
+#include "gbuffer.h"
+#include "sectionslice.h"
+#include "spawnmask.h"
+#include "surfaceindex.h"
+#include "tilecache.h"
 #include "mapview.h"
+#include "renderqueue.h"
 #include "identifier/blockidentifier.h"
 #include "identifier/biomeidentifier.h"
 #include "clamp.h"
 
+// Section only containing one invisible Block type (typically air)
+static inline bool isInvisible(const ChunkSection *section, const RenderBlockInfo *renderTable) {
+  return (section->blockPaletteLength <= 1) && section->blockPalette &&
+         (qAlpha(renderTable[section->blockPalette[0].cid].color) == 0);
+}
+
+// one bit per column of a Chunk, index is x + 16*z
+class ColumnMask {
+ public:
+  static const int WORDS = 16 * 16 / 64;
+  quint64 bits[WORDS];
+
+  void setAll()       { std::fill_n(bits, WORDS, ~Q_UINT64_C(0)); }
+  void clearAll()     { std::fill_n(bits, WORDS,  Q_UINT64_C(0)); }
+  bool any() const    { return (bits[0] | bits[1] | bits[2] | bits[3]) != 0; }
+  void set(int idx)   { bits[idx >> 6] |=  (Q_UINT64_C(1) << (idx & 63)); }
+  void clear(int idx) { bits[idx >> 6] &= ~(Q_UINT64_C(1) << (idx & 63)); }
+};
+
+// transparency of all Blocks in one Section, for each column one bit per layer
+// (bit 0 is the bottom layer), index is x + 16*z
+static void getTransparency(const ChunkSection *section, const RenderBlockInfo *renderTable, quint16 *columns) {
+  std::fill_n(columns, 16 * 16, 0);
+  if (!section) return;
+
+  // resolve the palette once, the shared legacy palette is too large for that
+  const int length = section->blockPaletteIsShared ? 0 : section->blockPaletteLength;
+  QVarLengthArray<quint16, 256> palette(length);
+  for (int i = 0; i < length; i++)
+    palette[i] = renderTable[section->blockPalette[i].cid].is(RenderBlockInfo::flgTransparent) ? 1 : 0;
+
+  for (int index = 0; index < 16 * 16 * 16; index++) {
+    quint16 blockid = section->blocks[index];
+    quint16 bit = (blockid < length) ? palette[blockid]
+                : (renderTable[section->getCompactId(index)].is(RenderBlockInfo::flgTransparent) ? 1 : 0);
+    columns[index & 0xff] |= bit << (index >> 8);
+  }
+}
+
+// Biomes of one Section, resolved once instead of for each Block
+class SectionBiomes {
+ public:
+  void resolve(const Chunk &chunk, const BiomeIdentifier &biomes, const ChunkSection *section, int sec);
+  // section has to contain y
+  const BiomeInfo &get(int offset, int y) const {
+    return *cells[perColumn ? offset
+                            : ((offset & 0x0f) >> 2) + ((offset >> 6) << 2) + (((y & 0x0f) >> 2) << 4)];
+  }
+
+ private:
+  const BiomeInfo *cells[16 * 16];  // 4x4x4 volumes, or columns up to Minecraft 1.14
+  bool perColumn;
+};
+
+void SectionBiomes::resolve(const Chunk &chunk, const BiomeIdentifier &biomes,
+                            const ChunkSection *section, int sec) {
+  const int version = chunk.getVersion();
+  perColumn = (version < 2203);
+  if (perColumn) {
+    // Minecraft <1.15 has fixed Biome per column
+    for (int offset = 0; offset < 16 * 16; offset++)
+      cells[offset] = &biomes.getBiome(static_cast<qint32>(chunk.getBiomeID(offset & 0x0f, 0, offset >> 4)));
+  } else if (version >= 2800) {
+    // Minecraft 1.18 has Y dependand Biome stored per Section
+    for (int idx = 0; idx < 4 * 4 * 4; idx++)
+      cells[idx] = &biomes.getBiome(static_cast<quint8>(section->biomes[idx]));
+  } else {
+    // Minecraft 1.15 has Y dependand Biome
+    for (int idx = 0; idx < 4 * 4 * 4; idx++)
+      cells[idx] = &biomes.getBiome(static_cast<qint32>(
+          chunk.getBiomeID((idx & 3) << 2, (sec << 4) + ((idx >> 4) << 2), ((idx >> 2) & 3) << 2)));
+  }
+}
+
 ChunkRenderer::ChunkRenderer(int cx, int cz, int y, int flags)
-  : cx(cx)
-  , cz(cz)
-  , depth(y)
+  : depth(y)
   , flags(flags)
   , cache(ChunkCache::Instance())
-{}
+{
+  chunks.append(QPoint(cx, cz));
+}
+
+void ChunkRenderer::add(int cx, int cz) {
+  chunks.append(QPoint(cx, cz));
+}
+
+void ChunkRenderer::merge(const ChunkRenderer &other) {
+  // shading queued for a former view is dropped, its Chunks are rendered for this one
+  if ((other.depth != depth) || (other.flags != flags)) {
+    TileCache &tiles = TileCache::Instance();
+    for (const QPoint &c : other.chunks)
+      tiles.cancelShade(TileID(c.x(), c.y(), other.depth, other.flags));
+  }
+  for (const QPoint &c : other.chunks)
+    if (!chunks.contains(c))
+      chunks.append(c);
+}
 
 
 void ChunkRenderer::run() {
-  // get existing Chunk entry from Cache
-  QSharedPointer<Chunk> chunk(cache.fetchCached(cx, cz));
-  // render Chunk data
-  if (chunk) {
-    renderChunk(chunk);
+  const QPoint &first = chunks.first();
+  RenderQueue::Instance().started(RenderQueue::getBatch(first.x(), first.y()), this);
+
+  // west to east, so the Chunk to the west is usually rendered already
+  std::sort(chunks.begin(), chunks.end(), [](const QPoint &a, const QPoint &b) {
+    return (a.y() < b.y()) || ((a.y() == b.y()) && (a.x() < b.x()));
+  });
+
+  TileCache &tiles = TileCache::Instance();
+  QVector<QPoint> updated(chunks);
+  for (const QPoint &c : chunks) {
+    const short *depthmap = NULL;
+    // only shading flags changed or Tile of a previous session,
+    // when queued as re-shade of a G-buffer or load from TileStore
+    QSharedPointer<RenderedTile> tile(tiles.shade(TileID(c.x(), c.y(), depth, flags)));
+    QSharedPointer<Chunk> chunk;
+    if (tile) {
+      depthmap = tile->depth;
+    } else if ((chunk = cache.fetchCached(c.x(), c.y())) && chunk->loaded) {
+      // render Chunk data from existing Chunk entry in Cache
+      // edge highlight across the seam, only from Tiles in memory
+      QSharedPointer<RenderedTile> west(tiles.fetchCached(TileID(c.x() - 1, c.y(), depth, flags)));
+      QSharedPointer<GBuffer> gbuffer = renderChunk(chunk, west ? west->depth : NULL);
+      // keep rendered result also when Chunk data gets evicted
+      tiles.insert(TileID(c.x(), c.y(), depth, flags), *chunk, gbuffer);
+      chunk->rendering = false;
+      depthmap = chunk->depth;
+    }
+    // Chunk to the east was rendered without knowing this one
+    const QPoint east(c.x() + 1, c.y());
+    if (depthmap && !chunks.contains(east) &&
+        tiles.stitch(TileID(east.x(), east.y(), depth, flags), depthmap))
+      updated.append(east);
   }
-  emit rendered(cx, cz);
+  emit rendered(updated);
 }
 
-void ChunkRenderer::renderChunk(QSharedPointer<Chunk> chunk) {
-  // threshold for mob spawn detection
-  const int lightSpawnSave = (chunk->version >= 2800)? 1 : 8;
+void ChunkRenderer::cancel() {
+  // Chunks can be rendered again when needed
+  TileCache &tiles = TileCache::Instance();
+  for (const QPoint &c : chunks) {
+    tiles.cancelShade(TileID(c.x(), c.y(), depth, flags));
+    QSharedPointer<Chunk> chunk(cache.fetchCached(c.x(), c.y()));
+    if (chunk)
+      chunk->rendering = false;
+  }
+}
 
-  int offset = 0;
-  uchar *bits = chunk->image;
-  short *depthbits = chunk->depth;
+// scan kernels exist for the flags in GBuffer::getScanFlags() only
+static constexpr int scanFlagsOf(int index) {
+  return ((index & 1) ? MapView::flgCaveMode    : 0) |
+         ((index & 2) ? MapView::flgSeaGround   : 0) |
+         ((index & 4) ? MapView::flgSingleLayer : 0);
+}
+
+static int scanIndexOf(int flags) {
+  return ((flags & MapView::flgCaveMode)    ? 1 : 0) |
+         ((flags & MapView::flgSeaGround)   ? 2 : 0) |
+         ((flags & MapView::flgSingleLayer) ? 4 : 0);
+}
+
+template <int FLAGS>
+void ChunkRenderer::scanKernel(const Chunk &chunk, int depth, const SurfaceIndex *index,
+                               SpawnMask *spawnMask, GBuffer &gbuffer) {
+  // flat Block table indexed by compact ID from the palette
+  const RenderBlockInfo *renderTable = BlockIdentifier::Instance().getRenderTable();
+  const BiomeIdentifier &biomes = BiomeIdentifier::Instance();
+  // tints may get replaced by a definition reload while rendering
+  const QSharedPointer<const TintTable> tints = BiomeIdentifier::Instance().getTints();
+  SectionBiomes sectionBiomes;
 
   // adapt y loop start/stop value to render depth and available data in Chunk
-  int startY = std::min(chunk->highest, this->depth);
-  int stopY  = chunk->lowest;
-  if (this->flags & MapView::flgSingleLayer) {
-    startY = this->depth;
-    stopY  = this->depth;
-  }
-
-  // render loop
-  for (int z = 0; z < 16; z++) {  // n->s
-    // we do not know the last y value from Chunk to the east, -> set special value
-    int lasty = -9999;
-    for (int x = 0; x < 16; x++, offset++) {  // e->w
-      // initialize color
-      uchar r = 0, g = 0, b = 0;
-      double alpha = 0.0;
-
-      int highest = -4096;  // highest block in current column
-      for (int y = startY; y >= stopY; y--) {  // top->down
-        // perform a one deep scan in SingleLayer mode
-        int sec = y >> 4;
-        const ChunkSection *section = chunk->getSectionByIdx(sec);
-        if (!section) {
-          y = (sec << 4) - 1;  // skip whole section
-          continue;
-        }
+  int startY = std::min(chunk.highest, depth);
+  int stopY  = chunk.lowest;
+  if (FLAGS & MapView::flgSingleLayer) {
+    startY = depth;
+    stopY  = depth;
+  }
 
-        // get BlockInfo from block value
-        BlockInfo &block = BlockIdentifier::Instance().getBlockInfo(section->getPaletteEntry(offset, y).hid);
-        if (block.alpha == 0.0) continue;
-
-        if (this->flags & MapView::flgSeaGround && block.isLiquid()) continue;
-
-        // get light value from one block above
-        int light = 0;
-        const ChunkSection *section1 = chunk->getSectionByY(y+1);
-        if (section1)
-          light = section1->getBlockLight(offset, y+1);
-        int light1 = light;
-        if (!(this->flags & MapView::flgLighting))
-          light = 13;
-        // y gradient detection / edge highlight
-        if ((alpha == 0.0) && (lasty != -9999)) {
-          if (lasty < y)
-            light += 2;
-          else if (lasty > y)
-            light -= 2;
-        }
-//        if (light < 0) light = 0;
-//        if (light > 15) light = 15;
-
-        // get Biome
-        const BiomeInfo &biome = (chunk->version >=2800) ?
-            BiomeIdentifier::Instance().getBiome((quint8)chunk->getBiomeID(x,y,z)) :
-            BiomeIdentifier::Instance().getBiome((qint32)chunk->getBiomeID(x,y,z));
-        // get current block color
-        QColor blockcolor = block.colors[15];  // get the color from Block definition
-        if (block.biomeWater()) {
-          blockcolor = biome.getBiomeWaterColor(blockcolor);
-        }
-        else if (block.biomeGrass()) {
-          blockcolor = biome.getBiomeGrassColor(blockcolor, y-64);
-        }
-        else if (block.biomeFoliage()) {
-          blockcolor = biome.getBiomeFoliageColor(blockcolor, y-64);
-        }
+  // state of all 16*16 columns as structure of arrays, index is x + 16*z
+  GBuffer::Sample layers[16 * 16][GBuffer::MAX_LAYERS];  // color samples top->down
+  int     count[16 * 16];    // number of samples in column
+  quint32 alpha[16 * 16];    // 8.24 fixed point, GBuffer::ALPHA_ONE = opaque
+  ColumnMask active;         // columns that still need more color samples
+  std::fill_n(count,   16 * 16, 0);
+  std::fill_n(alpha,   16 * 16, 0);
+  std::fill_n(gbuffer.highest, 16 * 16, -4096);
+  active.clearAll();
 
-        // shade color based on light value
-        double light_factor = pow(0.90,15-light);
-        quint32 colr = std::clamp( int(light_factor*blockcolor.red()),   0, 255 );
-        quint32 colg = std::clamp( int(light_factor*blockcolor.green()), 0, 255 );
-        quint32 colb = std::clamp( int(light_factor*blockcolor.blue()),  0, 255 );
-
-        if (this->flags & MapView::flgDepthShading) {
-          // Use a table to define depth-relative shade:
-          static const quint32 shadeTable[] = {
-            0, 12, 18, 22, 24, 26, 28, 29, 30, 31, 32};
-          size_t idx = std::min(static_cast<size_t>(this->depth - y),
-                            sizeof(shadeTable) / sizeof(*shadeTable) - 1);
-          quint32 shade = shadeTable[idx];
-          colr = colr - std::min(shade, colr);
-          colg = colg - std::min(shade, colg);
-          colb = colb - std::min(shade, colb);
-        }
+  // columns join the scan at their first visible Block
+  int start[16 * 16];  // y of first visible Block in column
+  int order[16 * 16];  // columns sorted by start, top->down
+  int pending = 0;     // next column in order to join the scan
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    start[offset] = index ? index->findVisible(offset, startY, FLAGS & MapView::flgSeaGround)
+                          : startY;
+    order[offset] = offset;
+  }
+  if (index)
+    std::stable_sort(order, order + 16 * 16, [&](int a, int b) { return start[a] > start[b]; });
+  auto join = [&](int y) {
+    while ((pending < 16 * 16) && (start[order[pending]] >= y))
+      active.set(order[pending++]);
+  };
 
-        if (this->flags & MapView::flgMobSpawn) {
-          // get block info from 1 and 2 above and 1 below
-          uint blid1(0), blid2(0), blidB(0);  // default to legacy air (todo: better handling of block above)
-          const ChunkSection *section2 = chunk->getSectionByY(y+2);
-          const ChunkSection *sectionB = chunk->getSectionByY(y-1);
-          if (section1) {
-            blid1 = section1->getPaletteEntry(offset, y+1).hid;
-          }
-          if (section2) {
-            blid2 = section2->getPaletteEntry(offset, y+2).hid;
-          }
-          if (sectionB) {
-            blidB = sectionB->getPaletteEntry(offset, y-1).hid;
-          }
-          BlockInfo &block2 = BlockIdentifier::Instance().getBlockInfo(blid2);
-          BlockInfo &block1 = BlockIdentifier::Instance().getBlockInfo(blid1);
-          BlockInfo &block0 = block;
-          BlockInfo &blockB = BlockIdentifier::Instance().getBlockInfo(blidB);
-          int light0 = section->getBlockLight(offset, y);
-
-           // spawn check #1: on top of solid block
-           if (block0.doesBlockHaveSolidTopSurface() &&
-               !block0.isBedrock() && light1 < lightSpawnSave &&
-               !block1.isBlockNormalCube() && block1.spawninside &&
-               !block1.isLiquid() &&
-               !block2.isBlockNormalCube() && block2.spawninside) {
-             colr = (colr + 256) / 2;
-             colg = (colg + 0) / 2;
-             colb = (colb + 192) / 2;
-           }
-           // spawn check #2: current block is transparent,
-           // but mob can spawn through from block below (e.g. snow)
-           if (blockB.doesBlockHaveSolidTopSurface() &&
-               !blockB.isBedrock() && light0 < lightSpawnSave &&
-               !block0.isBlockNormalCube() && block0.spawninside &&
-               !block0.isLiquid() &&
-               !block1.isBlockNormalCube() && block1.spawninside) {
-             colr = (colr + 192) / 2;
-             colg = (colg + 0) / 2;
-             colb = (colb + 256) / 2;
-           }
-           // water spawn check for Drowned, introduced with "Update Aquatic" (1.13)
-           if ((chunk->version >= 1478) &&
-               ((biome.isOceanBiome() && (y < 58)) || biome.isRiverBiome()) &&
-               (light0 < lightSpawnSave) &&
-               block0.biomeWater() &&
-               block1.biomeWater() ) {
-             colr = (colr + 256) / 2;
-             colg = (colg + 0) / 2;
-             colb = (colb + 128) / 2;
-           }
-        }
+  // section-major scan: peel one y-slice at a time for all unresolved columns
+  int y = startY;
+  while (y >= stopY) {
+    join(y);
+    if (!active.any()) {
+      // jump through air directly to the next column starting below
+      if ((pending == 16 * 16) || (start[order[pending]] < stopY))
+        break;
+      y = start[order[pending]];
+      continue;
+    }
+    int sec = y >> 4;
+    const ChunkSection *section = chunk.getSectionByIdx(sec);
+    if (!section || isInvisible(section, renderTable)) {
+      y = (sec << 4) - 1;  // skip whole section
+      continue;
+    }
 
-        if (this->flags & MapView::flgBiomeColors) {
-          colr = biome.colors[light].red();
-          colg = biome.colors[light].green();
-          colb = biome.colors[light].blue();
-        }
+    // Sections around the current slice do not change inside one slice
+    // (spawn bits are always kept, toggling Mob Spawn only needs a re-shade)
+    const int bottom = std::max(stopY, sec << 4);
+    const SpawnMask::Bits *spawnBits = spawnMask->getSection(chunk, sec);
+    sectionBiomes.resolve(chunk, biomes, section, sec);
+    for (; y >= bottom; y--) {
+      join(y);
+      if (!active.any()) break;
+      const int slice = (y & 0x0f) << 8;
+      const ChunkSection *section1 = chunk.getSectionByY(y+1);
 
-        // combine current block to final color
-        if (alpha == 0.0) {
-          // first color sample
-          alpha = block.alpha;
-          r = colr;
-          g = colg;
-          b = colb;
-          highest = y;
-        } else {
-          // combine further color samples with blending
-          r = (quint8)(alpha * r + (1.0 - alpha) * colr);
-          g = (quint8)(alpha * g + (1.0 - alpha) * colg);
-          b = (quint8)(alpha * b + (1.0 - alpha) * colb);
-          alpha += block.alpha * (1.0 - alpha);
-        }
+      for (int word = 0; word < ColumnMask::WORDS; word++) {
+        for (quint64 lanes = active.bits[word]; lanes; lanes &= lanes - 1) {
+          const int offset = (word << 6) + qCountTrailingZeroBits(lanes);
+
+          // get render info from block value
+          const RenderBlockInfo &block = renderTable[section->getCompactId(slice + offset)];
+          const quint32 blockalpha = qAlpha(block.color);
+          if (blockalpha == 0) continue;
+
+          if (FLAGS & MapView::flgSeaGround && block.is(RenderBlockInfo::flgLiquid)) continue;
 
-        // finish depth (Y) scanning when color is saturated enough
-        if (block.alpha == 1.0 || alpha > 0.9)
-          break;
-
-      } // top -> down
-
-      // finished to find color for current column, only continue for cave mode
-      if (this->flags & MapView::flgCaveMode) {
-        float cave_factor = 1.0;
-        int cave_test = 0;
-        for (int y=highest-1; (y >= stopY) && (cave_test < CaveShade::CAVE_DEPTH); y--, cave_test++) {  // top->down
-          // get section
-          const ChunkSection *section = chunk->getSectionByY(y);
-          if (!section) continue;
-          // get BlockInfo from block value
-          BlockInfo &block = BlockIdentifier::Instance().getBlockInfo(section->getPaletteEntry(offset, y).hid);
-          if (block.transparent) {
-            cave_factor -= CaveShade::getShade(cave_test);
+          // get light value from one block above
+          int light1 = 0;
+          if (section1)
+            light1 = section1->getBlockLight(offset, y+1);
+
+          // get Biome and current block color
+          const BiomeInfo &biome = sectionBiomes.get(offset, y);
+          QRgb blockcolor = block.color;  // get the color from Block definition
+          if (block.is(RenderBlockInfo::flgBiomeTint)) {
+            blockcolor = (biome.getTint(*tints, block.tint, y) & RGB_MASK) | (blockalpha << 24);
           }
+
+          // store color sample
+          GBuffer::Sample &sample = layers[offset][count[offset]++];
+          sample.color      = blockcolor;
+          sample.biomecolor = biome.basecolor;
+          sample.y          = y;
+          sample.light      = light1;
+          sample.spawn      = spawnBits->get(slice + offset);
+
+          // accumulate opacity like the shading will do
+          if (alpha[offset] == 0)
+            gbuffer.highest[offset] = y;
+          alpha[offset] = GBuffer::addAlpha(alpha[offset], blockalpha);
+
+          // finish depth (Y) scanning when color is saturated enough
+          // or no more samples can be stored (only with very low alpha values)
+          if (blockalpha == 255 || alpha[offset] > GBuffer::ALPHA_SATURATED || count[offset] == GBuffer::MAX_LAYERS)
+            active.clear(offset);
         }
-        cave_factor = std::max(cave_factor, 0.25f);
-        // darken color by blending with cave shade factor
-        r = (quint8)(cave_factor * r);
-        g = (quint8)(cave_factor * g);
-        b = (quint8)(cave_factor * b);
       }
+    }
+  }
+
+  // pack samples of all columns
+  int total = 0;
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    gbuffer.first[offset] = total;
+    total += count[offset];
+  }
+  gbuffer.first[16 * 16] = total;
+  gbuffer.samples.resize(total);
+  for (int offset = 0; offset < 16 * 16; offset++)
+    std::copy_n(layers[offset], count[offset], gbuffer.samples.begin() + gbuffer.first[offset]);
+
+  // finished to find color for all columns, only continue for cave mode
+  std::fill_n(gbuffer.cave, 16 * 16, CaveShade::ONE);
+  if (FLAGS & MapView::flgCaveMode) {
+    // y range touched by any column
+    int top = -4096, bottom = 4096;
+    for (int offset = 0; offset < 16 * 16; offset++) {
+      if (gbuffer.highest[offset] == -4096) continue;
+      top    = std::max(top,    gbuffer.highest[offset] - 1);
+      bottom = std::min(bottom, gbuffer.highest[offset] - CaveShade::CAVE_DEPTH);
+    }
+    bottom = std::max(bottom, stopY);
+    if (top < bottom) return;
+
+    // transparency of all Sections in that range
+    const int topSec    = top >> 4;
+    const int bottomSec = bottom >> 4;
+    QVarLengthArray<quint16, 4 * 16 * 16> transparent((topSec - bottomSec + 1) * 16 * 16);
+    for (int sec = bottomSec; sec <= topSec; sec++)
+      getTransparency(chunk.getSectionByIdx(sec), renderTable, transparent.data() + (sec - bottomSec) * 16 * 16);
+    auto columnOf = [&](int sec, int offset) -> quint32 {
+      return ((sec >= bottomSec) && (sec <= topSec)) ? transparent[(sec - bottomSec) * 16 * 16 + offset] : 0;
+    };
 
-      *depthbits++ = lasty = highest;
-      *bits++ = b;
-      *bits++ = g;
-      *bits++ = r;
-      *bits++ = 0xff;
+    // probe window of CAVE_DEPTH Blocks below the surface of each column
+    static_assert(CaveShade::CAVE_DEPTH == 16, "cave probe window has to fit into 16 bits");
+    for (int offset = 0; offset < 16 * 16; offset++) {
+      if (gbuffer.highest[offset] == -4096) continue;
+      const int low = gbuffer.highest[offset] - CaveShade::CAVE_DEPTH;  // lowest y in window
+      quint32 window = columnOf(low >> 4, offset) | (columnOf((low >> 4) + 1, offset) << 16);
+      window = (window >> (low & 0x0f)) & 0xffff;
+      if (low < stopY)
+        window &= 0xffffu << std::min(stopY - low, 16);
+      gbuffer.cave[offset] -= CaveShade::getShadeSum(window);
     }
   }
-  chunk->renderedAt = this->depth;
-  chunk->renderedFlags = this->flags;
 }
 
+// single layer: one y-slice of one Section maps straight through its palette
+template <int FLAGS>
+void ChunkRenderer::sliceKernel(const Chunk &chunk, int depth, const SurfaceIndex * /* index */,
+                                SpawnMask *spawnMask, GBuffer &gbuffer) {
+  const RenderBlockInfo *renderTable = BlockIdentifier::Instance().getRenderTable();
+  const BiomeIdentifier &biomes = BiomeIdentifier::Instance();
+  const QSharedPointer<const TintTable> tints = BiomeIdentifier::Instance().getTints();
 
-// define a shading curve for Cave Mode:
+  // no cave shading, as there is nothing above the single layer
+  std::fill_n(gbuffer.first,   16 * 16 + 1, 0);
+  std::fill_n(gbuffer.highest, 16 * 16, -4096);
+  std::fill_n(gbuffer.cave,    16 * 16, CaveShade::ONE);
 
-CaveShade::CaveShade()
-{
-  // calculate exponential function for cave shade
-  float cavesum = 0.0;
-  for (int i=0; i<CAVE_DEPTH; i++) {
-   caveshade[i] = 1/exp(i/(CAVE_DEPTH/2.0));
-    cavesum += caveshade[i];
+  const ChunkSection *section = chunk.getSectionByY(depth);
+  if (!section || isInvisible(section, renderTable))
+    return;
+  const ChunkSection *section1 = chunk.getSectionByY(depth+1);
+  const SectionSlice slice(*section, SectionSlice::axisY, depth & 0x0f);
+  const SpawnMask::Bits *spawnBits = spawnMask->getSection(chunk, depth >> 4);
+  SectionBiomes sectionBiomes;
+  sectionBiomes.resolve(chunk, biomes, section, depth >> 4);
+
+  gbuffer.samples.reserve(16 * 16);
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    gbuffer.first[offset] = gbuffer.samples.size();
+
+    const RenderBlockInfo &block = slice[offset];
+    const quint32 blockalpha = qAlpha(block.color);
+    if (blockalpha == 0) continue;
+    if (FLAGS & MapView::flgSeaGround && block.is(RenderBlockInfo::flgLiquid)) continue;
+
+    // get light value from one block above
+    int light1 = 0;
+    if (section1)
+      light1 = section1->getBlockLight(offset, depth+1);
+
+    const BiomeInfo &biome = sectionBiomes.get(offset, depth);
+    QRgb blockcolor = block.color;
+    if (block.is(RenderBlockInfo::flgBiomeTint)) {
+      blockcolor = (biome.getTint(*tints, block.tint, depth) & RGB_MASK) | (blockalpha << 24);
+    }
+
+    GBuffer::Sample sample;
+    sample.color      = blockcolor;
+    sample.biomecolor = biome.basecolor;
+    sample.y          = depth;
+    sample.light      = light1;
+    sample.spawn      = spawnBits->get(((depth & 0x0f) << 8) + offset);
+    gbuffer.samples.append(sample);
+    gbuffer.highest[offset] = depth;
   }
-  for (int i=0; i<CAVE_DEPTH; i++) {
-    caveshade[i] = 1.5 * caveshade[i] / cavesum;
+  gbuffer.first[16 * 16] = gbuffer.samples.size();
+}
+
+template <int... INDEX>
+const ChunkRenderer::ScanKernel *ChunkRenderer::getKernels(std::integer_sequence<int, INDEX...>) {
+  static const ScanKernel kernels[] = {
+    (scanFlagsOf(INDEX) & MapView::flgSingleLayer) ? &ChunkRenderer::sliceKernel<scanFlagsOf(INDEX)>
+                                                   : &ChunkRenderer::scanKernel<scanFlagsOf(INDEX)>... };
+  return kernels;
+}
+
+QSharedPointer<GBuffer> ChunkRenderer::renderChunk(QSharedPointer<Chunk> chunk, const short *west) {
+  // one specialized scan kernel for each combination of flags affecting the scan
+  static const ScanKernel *kernels = getKernels(std::make_integer_sequence<int, SCAN_KERNEL_COUNT>());
+
+  // build the surface index once the depth of an already rendered Chunk changes
+  // (keep a local reference, the index may get replaced by a concurrent render)
+  QSharedPointer<SurfaceIndex> surface;
+  {
+    QMutexLocker guard(&chunk->renderMutex);
+    surface = chunk->surfaceIndex;
   }
+  if ((!surface || !surface->isValid()) &&
+      (chunk->renderedAt != INT_MIN) && (chunk->renderedAt != this->depth)) {
+    surface.reset(new SurfaceIndex(*chunk));
+    QMutexLocker guard(&chunk->renderMutex);
+    chunk->surfaceIndex = surface;
+  }
+  const SurfaceIndex *index = (surface && surface->isValid()) ? surface.data() : nullptr;
+
+  // mob spawn detection is evaluated per Section on first use and kept with the Chunk
+  QSharedPointer<SpawnMask> spawn;
+  {
+    QMutexLocker guard(&chunk->renderMutex);
+    if (!chunk->spawnMask || !chunk->spawnMask->isValid())
+      chunk->spawnMask.reset(new SpawnMask());
+    spawn = chunk->spawnMask;
+  }
+
+  QSharedPointer<GBuffer> gbuffer(new GBuffer());
+  kernels[scanIndexOf(this->flags)](*chunk, this->depth, index, spawn.data(), *gbuffer);
+  gbuffer->entities = chunk->entities;
+  gbuffer->shade(this->flags, this->depth, chunk->image, chunk->depth, west);
+
+  chunk->renderedAt = this->depth;
+  chunk->renderedFlags = this->flags;
+  return gbuffer;
 }
 
-float CaveShade::getShade(int index) {
-  static CaveShade singleton;
-  return singleton.caveshade[index];
+void ChunkRenderer::renderCrossSection(const Chunk &chunk, int sec, SectionSlice::Axis axis, int pos, uchar *image) {
+  const ChunkSection *section = chunk.getSectionByIdx(sec);
+  if (!section) {
+    // missing Section is air
+    std::fill_n(image, 16 * 16 * 4, 0);
+    for (int i = 3; i < 16 * 16 * 4; i += 4)
+      image[i] = 0xff;
+    return;
+  }
+  const BiomeIdentifier &biomes = BiomeIdentifier::Instance();
+  const QSharedPointer<const TintTable> tints = BiomeIdentifier::Instance().getTints();
+  const SectionSlice slice(*section, axis, pos);
+  SectionBiomes sectionBiomes;
+  sectionBiomes.resolve(chunk, biomes, section, sec);
+
+  for (int index = 0; index < 16 * 16; index++) {
+    const int u = index & 0x0f;
+    const int y = (sec << 4) + 15 - (index >> 4);
+    const int offset = (axis == SectionSlice::axisX) ? (pos + 16 * u) : (u + 16 * pos);
+
+    const RenderBlockInfo &block = slice[index];
+    const quint32 blockalpha = qAlpha(block.color);
+    QRgb blockcolor = block.color;
+    if ((blockalpha > 0) && block.is(RenderBlockInfo::flgBiomeTint))
+      blockcolor = sectionBiomes.get(offset, y).getTint(*tints, block.tint, y);
+
+    // translucent Blocks are blended over black air
+    const quint32 a = blockalpha + (blockalpha >> 7);
+    *image++ = (qBlue(blockcolor)  * a) >> 8;
+    *image++ = (qGreen(blockcolor) * a) >> 8;
+    *image++ = (qRed(blockcolor)   * a) >> 8;
+    *image++ = 0xff;
+  }
 }
@@ -3,8 +3,16 @@
 #define CHUNKRENDERER_H
 
 #include <QObject>
+#include <QPoint>
 #include <QRunnable>
+#include <QVector>
+#include <utility>
 #include "chunkcache.h"
+#include "gbuffer.h"
+#include "sectionslice.h"
+#include "shading.h"
+#include "spawnmask.h"
+#include "surfaceindex.h"
 
 class ChunkRenderer : public QObject, public QRunnable {
   Q_OBJECT
@@ -13,36 +21,43 @@ class ChunkRenderer : public QObject, public QRunnable {
   ChunkRenderer(int cx, int cz, int y, int flags);
   ~ChunkRenderer() {}
 
+  // Chunks are rendered in batches, one task renders all of them
+  void add(int cx, int cz);
+  void merge(const ChunkRenderer &other);
+  const QVector<QPoint> &getChunks() const { return chunks; }
+  int getDepth() const { return depth; }
+  int getFlags() const { return flags; }
+
+  // task was removed from the RenderQueue before it started
+  void cancel();
+
  protected:
   void run();
 
  public:  // public to allow usage from WorldSave
-  void renderChunk(QSharedPointer<Chunk> chunk);
+  // west is the depth map of the Chunk to the west, if already rendered
+  QSharedPointer<GBuffer> renderChunk(QSharedPointer<Chunk> chunk, const short *west = NULL);
+  // vertical cut through one Section as 16x16 RGB32 image, rows top->down
+  static void renderCrossSection(const Chunk &chunk, int sec, SectionSlice::Axis axis, int pos, uchar *image);
 
  signals:
-  void rendered(int cx, int cz);
+  void rendered(QVector<QPoint> chunks);  // once for the whole batch
 
  private:
-  int cx, cz;
+  // scan kernel specialized at compile time for the flags changing the scan
+  typedef void (*ScanKernel)(const Chunk &chunk, int depth, const SurfaceIndex *index,
+                             SpawnMask *spawnMask, GBuffer &gbuffer);
+  static const int SCAN_KERNEL_COUNT = 1 << 3;  // Cave Mode, Sea Ground, Single Layer
+  template <int FLAGS> static void scanKernel(const Chunk &chunk, int depth, const SurfaceIndex *index,
+                                              SpawnMask *spawnMask, GBuffer &gbuffer);
+  template <int FLAGS> static void sliceKernel(const Chunk &chunk, int depth, const SurfaceIndex *index,
+                                               SpawnMask *spawnMask, GBuffer &gbuffer);
+  template <int... INDEX> static const ScanKernel *getKernels(std::integer_sequence<int, INDEX...>);
+
+  QVector<QPoint> chunks;  // in Chunk coordinates
   int depth;
   int flags;
   ChunkCache &cache;
 };
 
-class CaveShade {
- public:
-  // singleton: access to global usable instance
-  static float getShade(int index);
- private:
-  // singleton: prevent access to constructor and copyconstructor
-  CaveShade();
-  ~CaveShade() {}
-  CaveShade(const CaveShade &);
-  CaveShade &operator=(const CaveShade &);
-
- public:
-  static const int CAVE_DEPTH = 16;  // maximum depth caves are searched in cave mode
-  float caveshade[CAVE_DEPTH];
-};
-
 #endif // CHUNKRENDERER_H
@@ -0,0 +1,249 @@
+#include <QDataStream>
+#include <QDir>
+#include <algorithm>
+
+#include "chunkspill.h"
+
+// every slot can hold either a ChunkRecord or a SectionRecord
+static const int slotSize = 10304;
+
+ChunkSpill::ChunkSpill()
+  : file(NULL)
+  , data(NULL)
+  , slotCount(0)
+{
+  static_assert(sizeof(SectionRecord) <= slotSize, "SectionRecord does not fit into slot");
+  static_assert(sizeof(ChunkRecord)   <= slotSize, "ChunkRecord does not fit into slot");
+}
+
+ChunkSpill::~ChunkSpill() {
+  setup(false, 0);
+}
+
+bool ChunkSpill::setup(bool enabled, int maxMB) {
+  QMutexLocker guard(&mutex);
+  // drop current scratch file
+  releaseAll();
+  if (file) {
+    if (data)
+      file->unmap(data);
+    delete file;  // temporary file is removed from disk
+  }
+  file = NULL;
+  data = NULL;
+  slotCount = 0;
+  freeSlots.clear();
+
+  if (!enabled || (maxMB <= 0))
+    return false;
+
+  // create sparse scratch file and map it completely
+  qint64 size = qint64(maxMB) * 1024 * 1024;
+  file = new QTemporaryFile(QDir::tempPath() + "/minutor-spill-XXXXXX");
+  if (file->open() && file->resize(size))
+    data = file->map(0, size);
+  if (!data) {
+    delete file;
+    file = NULL;
+    return false;
+  }
+
+  slotCount = size / slotSize;
+  freeSlots.reserve(slotCount);
+  for (int i = slotCount - 1; i >= 0; i--)
+    freeSlots.append(i);
+  return true;
+}
+
+bool ChunkSpill::isEnabled() const {
+  QMutexLocker guard(&mutex);
+  return (data != NULL);
+}
+
+void ChunkSpill::clear() {
+  QMutexLocker guard(&mutex);
+  releaseAll();
+}
+
+void ChunkSpill::releaseAll() {
+  while (!order.isEmpty())
+    release(order.dequeue());
+}
+
+bool ChunkSpill::contains(const ChunkID &id) const {
+  QMutexLocker guard(&mutex);
+  return entries.contains(id);
+}
+
+int ChunkSpill::getUsage() const {
+  QMutexLocker guard(&mutex);
+  return (qint64(slotCount - freeSlots.size()) * slotSize) / (1024 * 1024);
+}
+
+int ChunkSpill::getMax() const {
+  QMutexLocker guard(&mutex);
+  return (qint64(slotCount) * slotSize) / (1024 * 1024);
+}
+
+uchar *ChunkSpill::slotData(int slot) const {
+  return data + qint64(slot) * slotSize;
+}
+
+bool ChunkSpill::allocate(int count) {
+  if (count > slotCount)
+    return false;
+  // evict oldest Chunks until enough slots are free
+  while ((freeSlots.size() < count) && !order.isEmpty())
+    release(order.dequeue());
+  return (freeSlots.size() >= count);
+}
+
+void ChunkSpill::release(const ChunkID &id) {
+  auto it = entries.find(id);
+  if (it == entries.end())
+    return;
+  freeSlots.append(it->slot);
+  for (auto &section : it->sections)
+    freeSlots.append(section.slot);
+  freeSlots += it->extraSlots;
+  entries.erase(it);
+}
+
+void ChunkSpill::store(const ChunkID &id, const Chunk &chunk) {
+  if (!isEnabled() || contains(id))
+    return;  // Chunk data never changes once loaded
+
+  // serialize everything of variable size: own Palettes and Entities
+  QByteArray extra;
+  {
+    QDataStream stream(&extra, QIODevice::WriteOnly);
+    for (const ChunkSection *cs : chunk.sections) {
+      if (!cs || cs->blockPaletteIsShared || !cs->blockPalette) continue;
+      for (int i = 0; i < std::max(1, cs->blockPaletteLength); i++) {
+        const PaletteEntry &entry = cs->blockPalette[i];
+        stream << entry.hid << entry.cid << entry.name << entry.properties;
+      }
+    }
+    stream << chunk.entities.size();
+    for (const auto &item : chunk.entities) {
+      const Entity *entity = dynamic_cast<const Entity*>(item.data());
+      stream << (entity != NULL);
+      if (entity)
+        entity->write(stream);
+    }
+  }
+  const int extraCount = (extra.size() + slotSize - 1) / slotSize;
+
+  QMutexLocker guard(&mutex);
+  if ((data == NULL) || entries.contains(id))
+    return;  // checked again, others may have stored meanwhile
+  if (!allocate(1 + chunk.sections.size() + extraCount))
+    return;
+
+  Entry entry;
+  entry.extraSize = extra.size();
+  for (int i = 0; i < extraCount; i++) {
+    entry.extraSlots.append(freeSlots.takeLast());
+    const int offset = i * slotSize;
+    memcpy(slotData(entry.extraSlots.last()), extra.constData() + offset,
+           std::min(slotSize, extra.size() - offset));
+  }
+
+  entry.slot = freeSlots.takeLast();
+  ChunkRecord *record = reinterpret_cast<ChunkRecord*>(slotData(entry.slot));
+  record->chunkX        = chunk.chunkX;
+  record->chunkZ        = chunk.chunkZ;
+  record->version       = chunk.version;
+  record->highest       = chunk.highest;
+  record->lowest        = chunk.lowest;
+  record->renderedAt    = chunk.renderedAt;
+  record->renderedFlags = chunk.renderedFlags;
+  memcpy(record->biomes, chunk.biomes, sizeof(record->biomes));
+  memcpy(record->image,  chunk.image,  sizeof(record->image));
+  memcpy(record->depth,  chunk.depth,  sizeof(record->depth));
+
+  for (auto it = chunk.sections.cbegin(); it != chunk.sections.cend(); ++it) {
+    const ChunkSection *cs = it.value();
+    if (!cs) continue;
+
+    Section section;
+    section.idx  = it.key();
+    section.slot = freeSlots.takeLast();
+    section.blockPaletteLength   = cs->blockPaletteLength;
+    section.blockPaletteIsShared = cs->blockPaletteIsShared || !cs->blockPalette;
+    section.blockPalette = section.blockPaletteIsShared ? cs->blockPalette : NULL;
+
+    SectionRecord *srecord = reinterpret_cast<SectionRecord*>(slotData(section.slot));
+    memcpy(srecord->blocks,     cs->blocks,     sizeof(srecord->blocks));
+    memcpy(srecord->biomes,     cs->biomes,     sizeof(srecord->biomes));
+    memcpy(srecord->blockLight, cs->blockLight, sizeof(srecord->blockLight));
+
+    entry.sections.append(section);
+  }
+
+  entries.insert(id, entry);
+  order.enqueue(id);
+}
+
+QSharedPointer<Chunk> ChunkSpill::load(const ChunkID &id) {
+  QMutexLocker guard(&mutex);
+  auto it = entries.constFind(id);
+  if ((data == NULL) || (it == entries.constEnd()))
+    return QSharedPointer<Chunk>();
+
+  QSharedPointer<Chunk> chunk(new Chunk());
+  const ChunkRecord *record = reinterpret_cast<const ChunkRecord*>(slotData(it->slot));
+  chunk->chunkX        = record->chunkX;
+  chunk->chunkZ        = record->chunkZ;
+  chunk->version       = record->version;
+  chunk->highest       = record->highest;
+  chunk->lowest        = record->lowest;
+  chunk->renderedAt    = record->renderedAt;
+  chunk->renderedFlags = record->renderedFlags;
+  memcpy(chunk->biomes, record->biomes, sizeof(chunk->biomes));
+  memcpy(chunk->image,  record->image,  sizeof(chunk->image));
+  memcpy(chunk->depth,  record->depth,  sizeof(chunk->depth));
+
+  QByteArray extra;
+  extra.reserve(it->extraSize);
+  for (int slot : it->extraSlots)
+    extra.append(reinterpret_cast<const char*>(slotData(slot)),
+                 std::min(slotSize, it->extraSize - extra.size()));
+  QDataStream stream(extra);
+
+  for (const auto &section : it->sections) {
+    ChunkSection *cs = new ChunkSection();
+    cs->blockPaletteLength   = section.blockPaletteLength;
+    cs->blockPaletteIsShared = section.blockPaletteIsShared;
+    if (section.blockPaletteIsShared) {
+      cs->blockPalette = section.blockPalette;
+    } else {
+      int len = std::max(1, section.blockPaletteLength);
+      cs->blockPalette = new PaletteEntry[len];
+      for (int i = 0; i < len; i++) {
+        PaletteEntry &entry = cs->blockPalette[i];
+        stream >> entry.hid >> entry.cid >> entry.name >> entry.properties;
+      }
+    }
+
+    const SectionRecord *srecord = reinterpret_cast<const SectionRecord*>(slotData(section.slot));
+    memcpy(cs->blocks,     srecord->blocks,     sizeof(cs->blocks));
+    memcpy(cs->biomes,     srecord->biomes,     sizeof(cs->biomes));
+    memcpy(cs->blockLight, srecord->blockLight, sizeof(cs->blockLight));
+    chunk->sections[section.idx] = cs;
+  }
+
+  int count = 0;
+  stream >> count;
+  for (int i = 0; (i < count) && (stream.status() == QDataStream::Ok); i++) {
+    bool isEntity = false;
+    stream >> isEntity;
+    if (!isEntity) continue;
+    QSharedPointer<OverlayItem> entity = Entity::read(stream);
+    chunk->entities.insertMulti(entity->type(), entity);
+  }
+
+  chunk->parsed = true;
+  chunk->finishLoading();  // summary of Entities, flags Chunk as loaded
+  return chunk;
+}
@@ -0,0 +1,80 @@
+#ifndef CHUNKSPILL_H_
+#define CHUNKSPILL_H_
+
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QTemporaryFile>
+#include <QVector>
+#include "chunk.h"
+#include "chunkid.h"
+
+// Optional disk backed tier for decoded Chunks.
+// Section data is stored in a memory mapped scratch file using a fixed
+// binary layout, so loading a spilled Chunk again costs a page-in instead
+// of a full zlib + NBT decode. Palettes and Entities are serialized into
+// slots as well, only the slot numbers stay in memory.
+// The scratch file is a temporary file and is removed on exit.
+// All methods are thread safe.
+class ChunkSpill {
+ public:
+  ChunkSpill();
+  ~ChunkSpill();
+
+  bool setup(bool enabled, int maxMB);  // (re)create scratch file, drops all content
+  bool isEnabled() const;
+  void clear();
+
+  bool contains(const ChunkID &id) const;
+  void store(const ChunkID &id, const Chunk &chunk);
+  QSharedPointer<Chunk> load(const ChunkID &id);
+  int  getUsage() const;  // in MB
+  int  getMax() const;    // in MB
+
+ private:
+  // fixed binary layout inside one slot of the scratch file
+  struct ChunkRecord {
+    qint32 chunkX, chunkZ;
+    qint32 version;
+    qint32 highest, lowest;
+    qint32 renderedAt, renderedFlags;
+    qint32 biomes[16 * 16 * 4];
+    uchar  image[16 * 16 * 4];
+    short  depth[16 * 16];
+  };
+  struct SectionRecord {
+    quint16 blocks[16 * 16 * 16];
+    quint8  biomes[4 * 4 * 4];
+    quint8  blockLight[16 * 16 * 16 / 2];
+  };
+
+  struct Section {
+    qint8         idx;
+    int           slot;
+    PaletteEntry *blockPalette;   // only a shared Palette, others are serialized
+    int           blockPaletteLength;
+    bool          blockPaletteIsShared;
+  };
+  struct Entry {
+    int              slot;        // slot of ChunkRecord
+    QVector<Section> sections;
+    QVector<int>     extraSlots;  // serialized Palettes and Entities
+    int              extraSize;   // in Bytes
+  };
+
+  uchar *slotData(int slot) const;
+  bool   allocate(int count);      // make sure that many slots are free
+  void   release(const ChunkID &id);
+  void   releaseAll();
+
+  QTemporaryFile *file;
+  uchar *data;
+  int    slotCount;
+  QVector<int> freeSlots;
+  QHash<ChunkID, Entry> entries;
+  QQueue<ChunkID> order;           // oldest first, for eviction
+  mutable QMutex mutex;
+};
+
+#endif  // CHUNKSPILL_H_
@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include "compressedchunk.h"
+#include "lz4.h"
+
+// raw layout of Section data as it is compressed
+static const int blocksSize = sizeof(ChunkSection::blocks);
+static const int biomesSize = sizeof(ChunkSection::biomes);
+static const int lightSize  = sizeof(ChunkSection::blockLight);
+static const int rawSize    = blocksSize + biomesSize + lightSize;
+
+CompressedChunk::CompressedChunk(const Chunk &chunk)
+  : shell(new Chunk())
+  , bytes(sizeof(Chunk) + sizeof(CompressedChunk))
+{
+  // copy everything except Sections
+  shell->chunkX        = chunk.chunkX;
+  shell->chunkZ        = chunk.chunkZ;
+  shell->version       = chunk.version;
+  shell->highest       = chunk.highest;
+  shell->lowest        = chunk.lowest;
+  shell->renderedAt    = chunk.renderedAt;
+  shell->renderedFlags = chunk.renderedFlags;
+  shell->entities      = chunk.entities;
+  memcpy(shell->biomes, chunk.biomes, sizeof(chunk.biomes));
+  memcpy(shell->image,  chunk.image,  sizeof(chunk.image));
+  memcpy(shell->depth,  chunk.depth,  sizeof(chunk.depth));
+
+  uchar raw[rawSize];
+  for (auto it = chunk.sections.cbegin(); it != chunk.sections.cend(); ++it) {
+    const ChunkSection *cs = it.value();
+    if (!cs) continue;
+
+    Section section;
+    section.idx = it.key();
+    // Palette entries are implicitly shared Qt types, copying is cheap
+    section.blockPaletteLength   = cs->blockPaletteLength;
+    section.blockPaletteIsShared = cs->blockPaletteIsShared;
+    if (cs->blockPaletteIsShared || !cs->blockPalette) {
+      section.blockPalette = cs->blockPalette;
+    } else {
+      section.blockPalette = new PaletteEntry[std::max(1, cs->blockPaletteLength)];
+      for (int i = 0; i < std::max(1, cs->blockPaletteLength); i++)
+        section.blockPalette[i] = cs->blockPalette[i];
+      bytes += cs->blockPaletteLength * sizeof(PaletteEntry);
+    }
+
+    memcpy(raw,                           cs->blocks,     blocksSize);
+    memcpy(raw + blocksSize,              cs->biomes,     biomesSize);
+    memcpy(raw + blocksSize + biomesSize, cs->blockLight, lightSize);
+    section.data = Lz4::compress(raw, rawSize);
+    bytes += section.data.size() + sizeof(Section);
+
+    sections.append(section);
+  }
+}
+
+CompressedChunk::~CompressedChunk() {
+  for (auto &section : sections) {
+    if (!section.blockPaletteIsShared)
+      delete[] section.blockPalette;
+  }
+}
+
+QSharedPointer<Chunk> CompressedChunk::restore() {
+  QSharedPointer<Chunk> chunk = shell;
+  shell.reset();
+  if (!chunk) return chunk;
+
+  uchar raw[rawSize];
+  for (auto &section : sections) {
+    ChunkSection *cs = new ChunkSection();
+    // ownership of Palette moves to the restored Section
+    cs->blockPalette         = section.blockPalette;
+    cs->blockPaletteLength   = section.blockPaletteLength;
+    cs->blockPaletteIsShared = section.blockPaletteIsShared;
+    section.blockPaletteIsShared = true;
+
+    if (Lz4::decompress(section.data, raw, rawSize)) {
+      memcpy(cs->blocks,     raw,                           blocksSize);
+      memcpy(cs->biomes,     raw + blocksSize,              biomesSize);
+      memcpy(cs->blockLight, raw + blocksSize + biomesSize, lightSize);
+    } else {
+      // should never happen, fall back to minecraft:air
+      memset(cs->blocks,     0, blocksSize);
+      memset(cs->biomes,     0, biomesSize);
+      memset(cs->blockLight, 0, lightSize);
+    }
+    chunk->sections[section.idx] = cs;
+  }
+  sections.clear();
+
+  chunk->loaded = true;  // needs to be at the end!
+  return chunk;
+}
+
+int CompressedChunk::size() const {
+  return bytes;
+}
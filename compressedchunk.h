@@ -0,0 +1,34 @@
+#ifndef COMPRESSEDCHUNK_H_
+#define COMPRESSEDCHUNK_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QSharedPointer>
+#include "chunk.h"
+
+// Cold Chunk kept in memory with compressed Section data.
+// Everything needed for drawing (image, depth, entities) stays
+// uncompressed in a shell Chunk without Sections.
+class CompressedChunk {
+ public:
+  explicit CompressedChunk(const Chunk &chunk);  // compress (Chunk is not modified)
+  ~CompressedChunk();
+
+  QSharedPointer<Chunk> restore();  // decompress, can only be called once
+  int size() const;                 // approximate memory footprint in bytes
+
+ private:
+  struct Section {
+    qint8         idx;
+    PaletteEntry *blockPalette;
+    int           blockPaletteLength;
+    bool          blockPaletteIsShared;
+    QByteArray    data;             // blocks, biomes and blockLight
+  };
+
+  QSharedPointer<Chunk> shell;
+  QList<Section> sections;
+  int bytes;
+};
+
+#endif  // COMPRESSEDCHUNK_H_
@@ -0,0 +1,150 @@
+#include <algorithm>
+
+#include "gbuffer.h"
+#include "shading.h"
+#include "mapview.h"
+#include "clamp.h"
+
+// blend two packed 0x00RRGGBB colors, weight a (0..ALPHA_ONE) is used for c1
+// the small bias keeps exact results from being truncated one step too low
+static inline quint32 blendRgb(quint32 c1, quint32 c2, quint32 a) {
+  const quint32 b = GBuffer::ALPHA_ONE - a;
+  const quint32 bias = 1 << 8;
+  quint32 r  = (((c1 >> 16) & 0xff) * a + ((c2 >> 16) & 0xff) * b + bias) >> 24;
+  quint32 g  = (((c1 >>  8) & 0xff) * a + ((c2 >>  8) & 0xff) * b + bias) >> 24;
+  quint32 bl = (( c1        & 0xff) * a + ( c2        & 0xff) * b + bias) >> 24;
+  return (r << 16) | (g << 8) | bl;
+}
+
+GBuffer::GBuffer() {
+  std::fill_n(first,   16 * 16 + 1, 0);
+  std::fill_n(highest, 16 * 16, -4096);
+  std::fill_n(cave,    16 * 16, CaveShade::ONE);
+}
+
+int GBuffer::getScanFlags(int flags) {
+  return flags & (MapView::flgCaveMode | MapView::flgSeaGround | MapView::flgSingleLayer);
+}
+
+int GBuffer::size() const {
+  return sizeof(GBuffer) + samples.size() * sizeof(Sample);
+}
+
+template <int FLAGS>
+void GBuffer::shadeKernel(int depth, uchar *image, short *depthmap,
+                          const short *west, int start, int stride) const {
+  for (int offset = start; offset < 16 * 16; offset += stride) {
+    const int x = offset & 0x0f;
+    quint32 rgb = 0;    // packed 0x00RRGGBB
+    quint32 alpha = 0;  // 8.24 fixed point, ALPHA_ONE = opaque
+
+    for (int i = first[offset]; i < first[offset + 1]; i++) {
+      const Sample &sample = samples[i];
+      const int y = sample.y;
+
+      int light = sample.light;
+      if (!(FLAGS & MapView::flgLighting))
+        light = 13;
+      // y gradient detection / edge highlight
+      // first column depends on the last column of the Chunk to the west
+      if ((alpha == 0) && ((x > 0) || west)) {
+        int lasty = (x > 0) ? highest[offset - 1] : west[offset + 15];
+        if (lasty < y)
+          light += 2;
+        else if (lasty > y)
+          light -= 2;
+      }
+
+      // shade color based on light value
+      quint32 light_factor = LightShade::getFactor(light);
+      quint32 colr = std::min<quint32>((light_factor * qRed(sample.color))   >> 16, 255);
+      quint32 colg = std::min<quint32>((light_factor * qGreen(sample.color)) >> 16, 255);
+      quint32 colb = std::min<quint32>((light_factor * qBlue(sample.color))  >> 16, 255);
+
+      if (FLAGS & MapView::flgDepthShading) {
+        // Use a table to define depth-relative shade:
+        static const quint32 shadeTable[] = {
+          0, 12, 18, 22, 24, 26, 28, 29, 30, 31, 32};
+        size_t idx = std::min(static_cast<size_t>(depth - y),
+                          sizeof(shadeTable) / sizeof(*shadeTable) - 1);
+        quint32 shade = shadeTable[idx];
+        colr = colr - std::min(shade, colr);
+        colg = colg - std::min(shade, colg);
+        colb = colb - std::min(shade, colb);
+      }
+
+      if (FLAGS & MapView::flgMobSpawn) {
+        if (sample.spawn & spawnOnTop) {
+          colr = (colr + 256) / 2;
+          colg = (colg + 0) / 2;
+          colb = (colb + 192) / 2;
+        }
+        if (sample.spawn & spawnThrough) {
+          colr = (colr + 192) / 2;
+          colg = (colg + 0) / 2;
+          colb = (colb + 256) / 2;
+        }
+        if (sample.spawn & spawnDrowned) {
+          colr = (colr + 256) / 2;
+          colg = (colg + 0) / 2;
+          colb = (colb + 128) / 2;
+        }
+      }
+
+      if (FLAGS & MapView::flgBiomeColors) {
+        quint32 biome_factor = LightShade::getFactor(std::clamp(light, 0, 15));
+        colr = (biome_factor * qRed(sample.biomecolor))   >> 16;
+        colg = (biome_factor * qGreen(sample.biomecolor)) >> 16;
+        colb = (biome_factor * qBlue(sample.biomecolor))  >> 16;
+      }
+
+      // combine current block to final color
+      const quint32 blockalpha = qAlpha(sample.color);
+      quint32 col = (colr << 16) | (colg << 8) | colb;
+      if (alpha == 0) {
+        // first color sample
+        rgb = col;
+      } else {
+        // combine further color samples with blending
+        rgb = blendRgb(rgb, col, alpha);
+      }
+      alpha = addAlpha(alpha, blockalpha);
+    }
+
+    if (FLAGS & MapView::flgCaveMode) {
+      int factor = std::max(cave[offset], CaveShade::ONE / 4);
+      // darken color by blending with cave shade factor
+      rgb = ((((rgb >> 16) & 0xff) * factor >> 16) << 16) |
+            ((((rgb >>  8) & 0xff) * factor >> 16) <<  8) |
+            ((( rgb        & 0xff) * factor >> 16));
+    }
+
+    if (depthmap)
+      depthmap[offset] = highest[offset];
+    uchar *pixel = image + offset * 4;
+    pixel[0] = rgb & 0xff;
+    pixel[1] = (rgb >> 8) & 0xff;
+    pixel[2] = (rgb >> 16) & 0xff;
+    pixel[3] = 0xff;
+  }
+}
+
+template <int... FLAGS>
+const GBuffer::ShadeKernel *GBuffer::getKernels(std::integer_sequence<int, FLAGS...>) {
+  static const ShadeKernel kernels[] = { &GBuffer::shadeKernel<FLAGS>... };
+  return kernels;
+}
+
+void GBuffer::shade(int flags, int depth, uchar *image, short *depthmap, const short *west) const {
+  // shading flags occupy the lowest bits of MapView flags
+  static_assert((MapView::flgLighting | MapView::flgMobSpawn | MapView::flgCaveMode |
+                 MapView::flgDepthShading | MapView::flgBiomeColors) == KERNEL_COUNT - 1,
+                "shading flags have to be the lowest MapView flags");
+  static const ShadeKernel *kernels = getKernels(std::make_integer_sequence<int, KERNEL_COUNT>());
+  (this->*kernels[flags & (KERNEL_COUNT - 1)])(depth, image, depthmap, west, 0, 1);
+}
+
+void GBuffer::shadeEdge(int flags, int depth, uchar *image, const short *west) const {
+  static const ShadeKernel *kernels = getKernels(std::make_integer_sequence<int, KERNEL_COUNT>());
+  (this->*kernels[flags & (KERNEL_COUNT - 1)])(depth, image, NULL, west, 0, 16);
+}
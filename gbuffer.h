@@ -0,0 +1,71 @@
+#ifndef GBUFFER_H_
+#define GBUFFER_H_
+
+#include <QColor>
+#include <QVector>
+#include <utility>
+#include "chunk.h"
+
+// Result of scanning the Block data of one Chunk, before shading.
+// It keeps every color sample that contributes to a column. Changing a
+// shading flag (Lighting, Mob Spawn, Depth Shading, Biome Colors) only
+// needs a re-shade of this buffer, not another scan of the Blocks.
+class GBuffer {
+ public:
+  static const int MAX_LAYERS = 16;  // translucent layers kept per column
+
+  // result bits of mob spawn detection, done during every scan
+  enum {
+    spawnOnTop   = 1 << 0,  // on top of solid Block
+    spawnThrough = 1 << 1,  // through transparent Block from Block below
+    spawnDrowned = 1 << 2   // water spawn
+  };
+
+  struct Sample {
+    QRgb   color;       // Biome tinted Block color, alpha channel is Block alpha
+    QRgb   biomecolor;  // base color of Biome for "Biome Colors" mode
+    short  y;
+    quint8 light;       // Block light from one Block above
+    quint8 spawn;       // mob spawn detection bits
+  };
+
+  // accumulated opacity of a column, 8.24 fixed point
+  // (fine enough to stop scanning at the same Block as floating point would)
+  static const quint32 ALPHA_ONE       = 1u << 24;
+  static const quint32 ALPHA_SATURATED = 15099494;  // 0.9, scanning stops above
+
+  // add a Block with 8 bit alpha below the accumulated opacity of a column
+  static quint32 addAlpha(quint32 alpha, quint32 blockalpha) {
+    return alpha + (blockalpha * (ALPHA_ONE - alpha) + 127) / 255;
+  }
+
+  GBuffer();
+
+  // flags that change which Blocks are sampled, a GBuffer is only valid for these
+  static int getScanFlags(int flags);
+
+  // west is the depth map of the Chunk to the west, used for the edge highlight
+  // of the first column, NULL when unknown
+  void shade(int flags, int depth, uchar *image, short *depthmap, const short *west = NULL) const;
+  // shade the first column again, once the Chunk to the west is known
+  void shadeEdge(int flags, int depth, uchar *image, const short *west) const;
+  int  size() const;  // memory footprint in Bytes
+
+  QVector<Sample>  samples;            // all columns, each column top->down
+  quint16          first[16 * 16 + 1]; // index of first Sample of each column
+  short            highest[16 * 16];   // y of first Sample, -4096 when empty
+  int              cave[16 * 16];      // cave shade factor, 16.16 fixed point
+  Chunk::EntityMap entities;
+
+ private:
+  // shading kernel specialized at compile time for one set of MapView flags
+  // columns are shaded from offset start in steps of stride
+  typedef void (GBuffer::*ShadeKernel)(int depth, uchar *image, short *depthmap,
+                                       const short *west, int start, int stride) const;
+  static const int KERNEL_COUNT = 1 << 5;  // all combinations of shading flags
+  template <int FLAGS> void shadeKernel(int depth, uchar *image, short *depthmap,
+                                        const short *west, int start, int stride) const;
+  template <int... FLAGS> static const ShadeKernel *getKernels(std::integer_sequence<int, FLAGS...>);
+};
+
+#endif  // GBUFFER_H_
@@ -15,6 +15,7 @@ Copyright (c) 2016, EtlamGit
 // BiomeInfo
 // --------- --------- --------- ---------
 
+static int nextTintSlot = 0;  // Biomes are only created by the GUI thread
 static BiomeInfo unknownBiome;
 
 BiomeInfo::BiomeInfo()
@@ -28,6 +29,8 @@ BiomeInfo::BiomeInfo()
   , humidity(0.5)
   , enabledwatermodifier(false)
   , watermodifier(255,255,255)
+  , basecolor(qRgb(0, 0, 0))
+  , tintSlot(nextTintSlot++)
 {}
 
 
@@ -188,7 +191,9 @@ QColor BiomeInfo::getBiomeWaterColor( QColor watercolor ) const
 // BiomeIdentifier
 // --------- --------- --------- ---------
 
-BiomeIdentifier::BiomeIdentifier() {}
+BiomeIdentifier::BiomeIdentifier()
+  : tints(new TintTable{0, QVector<QRgb>()})
+{}
 
 BiomeIdentifier::~BiomeIdentifier() {
   for (int i = 0; i < packs.length(); i++) {
@@ -212,6 +217,39 @@ const BiomeInfo &BiomeIdentifier::getBiome(int id) const {
   }
 }
 
+QRgb BiomeInfo::calculateTint(const T_TintClass &tint, int y) const
+{
+  switch (tint.kind) {
+    case tintGrass:
+      return getBiomeGrassColor(QColor(tint.color), y - 64).rgb();
+    case tintFoliage:
+      return getBiomeFoliageColor(QColor(tint.color), y - 64).rgb();
+    case tintWater:
+    default:
+      return getBiomeWaterColor(QColor(tint.color)).rgb();
+  }
+}
+
+// fill the row of one Biome in a TintTable
+static void fillTints(const BiomeInfo &biome, const QVector<BiomeInfo::T_TintClass> &classes,
+                      TintTable &table)
+{
+  QRgb *row = table.colors.data() + biome.tintSlot * classes.size() * BiomeInfo::tintBands;
+  for (int c = 0; c < classes.size(); c++) {
+    for (int band = 0; band < BiomeInfo::tintBands; band++) {
+      // Water does not depend on elevation
+      if ((classes[c].kind == BiomeInfo::tintWater) && (band > 0)) {
+        row[c * BiomeInfo::tintBands + band] = row[c * BiomeInfo::tintBands];
+        continue;
+      }
+      // evaluate in the middle of each band
+      int y = BiomeInfo::tintMinY + band * BiomeInfo::tintBandHeight + BiomeInfo::tintBandHeight / 2;
+      row[c * BiomeInfo::tintBands + band] = biome.calculateTint(classes[c], y);
+    }
+  }
+}
+
+
 // new Biomes after Cliffs & Caves update (1.18)
 const BiomeInfo &BiomeIdentifier::getBiome(quint8 id) const {
   if (id < this->biomes18.length())
@@ -230,6 +268,45 @@ const BiomeInfo &BiomeIdentifier::getBiome(QString id) const {
   return unknownBiome;
 }
 
+quint16 BiomeIdentifier::getTintClass(BiomeInfo::TintKind kind, QRgb color) {
+  QMutexLocker locker(&tintMutex);
+  BiomeInfo::T_TintClass tint = { kind, color };
+  int idx = tintClasses.indexOf(tint);
+  if (idx < 0) {
+    idx = tintClasses.size();
+    tintClasses.append(tint);
+  }
+  return idx;
+}
+
+QRgb BiomeIdentifier::calculateTint(const BiomeInfo &biome, int tintClass, int y) {
+  QMutexLocker locker(&tintMutex);
+  if (tintClass >= tintClasses.size())
+    return qRgb(0xff, 0x00, 0xff);
+  return biome.calculateTint(tintClasses[tintClass], y);
+}
+
+void BiomeIdentifier::updateTints() {
+  QMutexLocker locker(&tintMutex);
+  // renders still use the old table, so a new one is built and published
+  TintTable *table = new TintTable;
+  table->classes = tintClasses.size();
+  table->colors.resize(nextTintSlot * tintClasses.size() * BiomeInfo::tintBands);
+  fillTints(unknownBiome, tintClasses, *table);
+  for (int pack = 0; pack < packs.length(); pack++) {
+    for (BiomeInfo *bi : packs[pack])
+      fillTints(*bi, tintClasses, *table);
+    for (BiomeInfo *bi : packs18[pack])
+      fillTints(*bi, tintClasses, *table);
+  }
+  tints = QSharedPointer<const TintTable>(table);
+}
+
+QSharedPointer<const TintTable> BiomeIdentifier::getTints() {
+  QMutexLocker locker(&tintMutex);
+  return tints;
+}
+
 void BiomeIdentifier::enableDefinitions(int pack) {
   if (pack < 0) return;
   int len = packs[pack].length();
@@ -257,6 +334,7 @@ int BiomeIdentifier::addDefinitions(JSONArray *data, JSONArray *data18, int pack
   if (data18) parseBiomeDefinitions2800(data18, pack);
 
   updateBiomeDefinition();
+  updateTints();
   return pack;
 }
 
@@ -329,6 +407,7 @@ void BiomeIdentifier::parseBiomeDefinitions0000(JSONArray *data, int pack) {
                                 light_factor*biomecolor.green(),
                                 light_factor*biomecolor.blue());
       }
+      biome->basecolor = biome->colors[15].rgb();
 
       packs[pack].append(biome);
     }
@@ -412,6 +491,7 @@ void BiomeIdentifier::parseBiomeDefinitions2800(JSONArray *data18, int pack) {
                                 light_factor*biomecolor.green(),
                                 light_factor*biomecolor.blue());
       }
+      biome->basecolor = biome->colors[15].rgb();
 
       packs18[pack].append(biome);
     }
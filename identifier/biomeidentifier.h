@@ -6,7 +6,12 @@
 #include <QList>
 #include <QString>
 #include <QColor>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+#include <algorithm>
 class JSONArray;
+struct TintTable;
 
 
 class BiomeInfo {
@@ -20,6 +25,21 @@ class BiomeInfo {
   bool   isOceanBiome() const { return ocean; };
   bool   isRiverBiome() const { return river; };
 
+  // Biome tint of Blocks with Grass, Foliage or Water color
+  // precomputed per tint class and elevation band
+  enum TintKind { tintGrass, tintFoliage, tintWater };
+  typedef struct T_TintClass {
+    TintKind kind;
+    QRgb     color;  // base color of Block
+    bool operator==(const T_TintClass &o) const { return kind == o.kind && color == o.color; }
+  } T_TintClass;
+  static const int tintMinY       = -64;
+  static const int tintBandHeight = 8;
+  static const int tintBands      = 48;  // covers -64 .. 319
+
+  QRgb getTint(const TintTable &table, int tintClass, int y) const;
+  QRgb calculateTint(const T_TintClass &tint, int y) const;
+
   // public members
  public:
   int     id;   // numerical ID
@@ -33,9 +53,12 @@ class BiomeInfo {
   bool    enabledwatermodifier;
   QColor  watermodifier;
   QColor  colors[16];
+  QRgb    basecolor;  // colors[15] packed, for "Biome Colors" mode in render kernels
+  int     tintSlot;   // row of this Biome in the TintTable
 
   // private methods and members
  private:
+
   typedef struct T_BiomeCorner {
     int red;
     int green;
@@ -47,6 +70,12 @@ class BiomeInfo {
   static QColor mixColor( QColor colorizer, QColor blockcolor );
 };
 
+// Biome tints of all Biomes, never changed once published
+struct TintTable {
+  int           classes;  // tint classes per Biome
+  QVector<QRgb> colors;   // [Biome tintSlot][tint class][elevation band]
+};
+
 class BiomeIdentifier {
  public:
   // singleton: access to global usable instance
@@ -60,6 +89,12 @@ class BiomeIdentifier {
   const BiomeInfo &getBiome(quint8 id) const;
   const BiomeInfo &getBiome(QString id) const;
 
+  quint16 getTintClass(BiomeInfo::TintKind kind, QRgb color);  // registers new classes
+  QRgb    calculateTint(const BiomeInfo &biome, int tintClass, int y);
+  void    updateTints();
+  // current tints, a render keeps its snapshot while definitions get reloaded
+  QSharedPointer<const TintTable> getTints();
+
 private:
   // singleton: prevent access to constructor and copyconstructor
   BiomeIdentifier();
@@ -76,6 +111,21 @@ private:
   // new Biomes after Cliffs & Caves update (1.18)
   QList<BiomeInfo*>         biomes18; // consolidated Biome mapping
   QList<QList<BiomeInfo*> > packs18;  // raw data of all available packs
+
+  QVector<BiomeInfo::T_TintClass> tintClasses;
+  QSharedPointer<const TintTable> tints;
+  QMutex                          tintMutex;  // for tintClasses and tints
 };
 
+inline QRgb BiomeInfo::getTint(const TintTable &table, int tintClass, int y) const {
+  if (tintClass < table.classes) {
+    int band = std::min(std::max((y - tintMinY) / tintBandHeight, 0), tintBands - 1);
+    int idx  = (tintSlot * table.classes + tintClass) * tintBands + band;
+    if (idx < table.colors.size())
+      return table.colors[idx];
+  }
+  // tint class or Biome registered after last update
+  return BiomeIdentifier::Instance().calculateTint(*this, tintClass, y);
+}
+
 #endif  // BIOMEIDENTIFIER_H_
@@ -6,6 +6,7 @@
 #include <cmath>
 
 #include "blockidentifier.h"
+#include "biomeidentifier.h"
 #include "json/json.h"
 
 static BlockInfo unknownBlock;
@@ -95,6 +96,12 @@ BlockIdentifier::BlockIdentifier() {
   unknownBlock.alpha = 1.0;
   // TODO: Hoist string literal into named constant
   unknownBlock.setName("Unknown Block");
+
+  // compact ID 0 is reserved for (legacy) air with hid 0
+  renderTable = new RenderBlockInfo[maxCompactIds];
+  compactIds.insert(0, 0);
+  compactHids.append(0);
+  updateRenderInfo(0);
 }
 
 BlockIdentifier::~BlockIdentifier() {
@@ -102,6 +109,7 @@ BlockIdentifier::~BlockIdentifier() {
     for (int j = 0; j < packs[i].length(); j++)
       delete packs[i][j];
   }
+  delete[] renderTable;
 }
 
 BlockIdentifier& BlockIdentifier::Instance() {
@@ -126,6 +134,52 @@ QList<quint32> BlockIdentifier::getKnownIds() const
   return blocks.keys();
 }
 
+quint16 BlockIdentifier::getCompactId(uint hid) {
+  QMutexLocker locker(&compactMutex);
+  auto itr = compactIds.find(hid);
+  if (itr != compactIds.end())
+    return itr.value();
+
+  if (compactHids.size() >= maxCompactIds) {
+    qWarning() << "Too many different Blocks, rendering" << hid << "as air";
+    return 0;
+  }
+  quint16 cid = compactHids.size();
+  compactIds.insert(hid, cid);
+  compactHids.append(hid);
+  updateRenderInfo(cid);
+  return cid;
+}
+
+void BlockIdentifier::updateRenderInfo(quint16 cid) {
+  BlockInfo &block = getBlockInfo(compactHids[cid]);
+  RenderBlockInfo &info = renderTable[cid];
+  QRgb color    = block.colors[15].rgb();
+  info.color    = qRgba(qRed(color), qGreen(color), qBlue(color),
+                        qBound(0, qRound(block.alpha * 255), 255));
+  info.tint     = 0;
+  info.flags    = 0;
+  if (block.isLiquid())       info.flags |= RenderBlockInfo::flgLiquid;
+  if (block.transparent)      info.flags |= RenderBlockInfo::flgTransparent;
+  if (block.biomeWater())     info.flags |= RenderBlockInfo::flgBiomeWater;
+  if (block.biomeGrass())     info.flags |= RenderBlockInfo::flgBiomeGrass;
+  if (block.biomeFoliage())   info.flags |= RenderBlockInfo::flgBiomeFoliage;
+  if (block.spawninside)      info.flags |= RenderBlockInfo::flgSpawnInside;
+  if (block.doesBlockHaveSolidTopSurface() && !block.isBedrock())
+                              info.flags |= RenderBlockInfo::flgSpawnOnTop;
+  if (block.isBlockNormalCube())
+                              info.flags |= RenderBlockInfo::flgNormalCube;
+
+  // Biome dependant color is taken from tint table
+  BiomeIdentifier &bi = BiomeIdentifier::Instance();
+  if (block.biomeWater())
+    info.tint = bi.getTintClass(BiomeInfo::tintWater, info.color);
+  else if (block.biomeGrass())
+    info.tint = bi.getTintClass(BiomeInfo::tintGrass, info.color);
+  else if (block.biomeFoliage())
+    info.tint = bi.getTintClass(BiomeInfo::tintFoliage, info.color);
+}
+
 void BlockIdentifier::enableDefinitions(int pack) {
   if (pack < 0) return;
   int len = packs[pack].length();
@@ -148,6 +202,13 @@ int BlockIdentifier::addDefinitions(JSONArray *defs, int pack) {
   int len = defs->length();
   for (int i = 0; i < len; i++)
     parseDefinition(dynamic_cast<JSONObject *>(defs->at(i)), NULL, pack);
+
+  // refresh render data of already assigned compact IDs
+  QMutexLocker locker(&compactMutex);
+  for (int cid = 0; cid < compactHids.size(); cid++)
+    updateRenderInfo(cid);
+  BiomeIdentifier::Instance().updateTints();
+  generation.ref();
   return pack;
 }
 
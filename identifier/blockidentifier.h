@@ -7,6 +7,9 @@
 #include <QHash>
 #include <QList>
 #include <QColor>
+#include <QMutex>
+#include <QVector>
+#include <QAtomicInt>
 
 class JSONArray;
 class JSONObject;
@@ -69,6 +72,29 @@ class BlockInfo {
   bool    foliage;
 };
 
+// hot subset of BlockInfo used by the render loop
+// kept in a flat table indexed by compact ID, 8 Bytes = 8 entries per cache line
+class RenderBlockInfo {
+ public:
+  enum {
+    flgLiquid       = 1 << 0,
+    flgTransparent  = 1 << 1,
+    flgBiomeWater   = 1 << 2,
+    flgBiomeGrass   = 1 << 3,
+    flgBiomeFoliage = 1 << 4,
+    flgSpawnInside  = 1 << 5,
+    flgSpawnOnTop   = 1 << 6,  // solid top surface and not Bedrock
+    flgNormalCube   = 1 << 7,
+    flgBiomeTint    = flgBiomeWater | flgBiomeGrass | flgBiomeFoliage
+  };
+
+  QRgb    color;     // brightest color (light level 15), alpha channel is Block alpha
+  quint16 flags;
+  quint16 tint;      // tint class in BiomeIdentifier, when flgBiomeTint
+
+  bool is(quint32 flag) const { return (flags & flag) != 0; }
+};
+
 class BlockIdentifier {
  public:
   // singleton: access to global usable instance
@@ -82,6 +108,12 @@ class BlockIdentifier {
 
   QList<quint32> getKnownIds() const;
 
+  // dense IDs for the render loop, assigned on first use and never reused
+  quint16 getCompactId(uint hid);
+  const RenderBlockInfo &getRenderInfo(quint16 cid) const { return renderTable[cid]; }
+  const RenderBlockInfo *getRenderTable() const { return renderTable; }
+  int  getGeneration() const { return generation.load(); }  // changes whenever render data changes
+
  private:
   // singleton: prevent access to constructor and copyconstructor
   BlockIdentifier();
@@ -90,8 +122,16 @@ class BlockIdentifier {
   BlockIdentifier &operator=(const BlockIdentifier &);
 
   void parseDefinition(JSONObject *block, BlockInfo *parent, int pack);
+  void updateRenderInfo(quint16 cid);
   QMap<uint, BlockInfo*>    blocks;
   QList<QList<BlockInfo*> > packs;
+
+  static const int maxCompactIds = 1 << 16;
+  QHash<uint, quint16> compactIds;    // hid -> compact ID
+  QVector<uint>        compactHids;   // compact ID -> hid
+  RenderBlockInfo     *renderTable;   // maxCompactIds entries, never reallocated
+  QAtomicInt           generation;
+  QMutex               compactMutex;
 };
 
 #endif  // BLOCKIDENTIFIER_H_
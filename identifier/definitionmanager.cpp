@@ -164,6 +164,19 @@ void DefinitionManager::refresh() {
   }
 }
 
+quint32 DefinitionManager::getDefinitionsHash() const {
+  // combine all definitions in priority order with version, content and state
+  QString state;
+  for (int i = 0; i < sorted.length(); i++) {
+    QString path = sorted[i].toString();
+    if (!definitions.contains(path)) continue;
+    const Definition &def = definitions[path];
+    state += def.path + ":" + def.version + ":" + QString::number(def.contentHash) + ":" +
+             (def.enabled ? "1" : "0") + ";";
+  }
+  return qHash(state);
+}
+
 void DefinitionManager::selectedPack(QTableWidgetItem *item,
                                      QTableWidgetItem *) {
   emit packSelected(item != NULL);
@@ -409,8 +422,9 @@ void DefinitionManager::loadDefinition(QString path) {
     std::unique_ptr<JSONData> def;
     QFile f(path);
     if (!f.open(QIODevice::ReadOnly)) return;
+    const QByteArray content = f.readAll();
     try {
-      def = JSON::parse(f.readAll());
+      def = JSON::parse(content);
       f.close();
     } catch (JSONParseException e) {
       f.close();
@@ -420,6 +434,7 @@ void DefinitionManager::loadDefinition(QString path) {
     d.name = def->at("name")->asString();
     d.version = def->at("version")->asString();
     d.path = path;
+    d.contentHash = qHash(content);
     d.update = def->at("update")->asString();
     QString type = def->at("type")->asString();
     QString key = d.name + type;
@@ -454,8 +469,9 @@ void DefinitionManager::loadDefinition(QString path) {
     if (!zip.open())
       return;
     std::unique_ptr<JSONData> info;
+    const QByteArray infoContent = zip.get("pack_info.json");
     try {
-      info = JSON::parse(zip.get("pack_info.json"));
+      info = JSON::parse(infoContent);
     } catch (JSONParseException e) {
       zip.close();
       return;
@@ -465,6 +481,7 @@ void DefinitionManager::loadDefinition(QString path) {
     d.version = info->at("version")->asString();
     d.update = info->at("update")->asString();
     d.path = path;
+    d.contentHash = qHash(infoContent);
     d.enabled = true;
     d.id = 0;
     d.type = Definition::Pack;
@@ -475,8 +492,10 @@ void DefinitionManager::loadDefinition(QString path) {
     QString key = d.name+"pack";
     for (int i = 0; i < info->at("data")->length(); i++) {
       std::unique_ptr<JSONData> def;
+      const QByteArray content = zip.get(info->at("data")->at(i)->asString());
+      d.contentHash = qHash(content, d.contentHash);
       try {
-        def = JSON::parse(zip.get(info->at("data")->at(i)->asString()));
+        def = JSON::parse(content);
       } catch (JSONParseException e) {
         continue;
       }
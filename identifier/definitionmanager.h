@@ -29,6 +29,7 @@ struct Definition {
   enum {Block, Biome, Dimension, Entity, Pack, Converter} type;
   int id;
   bool enabled;
+  quint32 contentHash;  // of all files read, packs can change without a version bump
   // for packs only
   int blockid, biomeid, dimensionid, entityid;
 };
@@ -44,6 +45,7 @@ class DefinitionManager : public QWidget {
   QSize sizeHint() const;
 
   void autoUpdate();
+  quint32 getDefinitionsHash() const;  // changes whenever the active definitions change
 
  signals:
   void packSelected(bool on);
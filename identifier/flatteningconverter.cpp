@@ -5,6 +5,7 @@
 #include <cmath>
 
 #include "flatteningconverter.h"
+#include "blockidentifier.h"
 #include "json/json.h"
 
 const QString PaletteEntry::legacyBlockIdProperty = "lbid";
@@ -17,8 +18,10 @@ FlatteningConverter::FlatteningConverter() {
   // TODO: Hoist "Unknown Block" literal into constant
   QString unknownBlockName = "Unknown Block";
   uint unknownBlockHID = qHash(unknownBlockName);
+  quint16 unknownBlockCID = BlockIdentifier::Instance().getCompactId(unknownBlockHID);
   for (int idx = 0; idx < paletteLength; idx++) {
     palette[idx].hid = unknownBlockHID;
+    palette[idx].cid = unknownBlockCID;
     palette[idx].name = unknownBlockName;
     palette[idx].properties[PaletteEntry::legacyBlockIdProperty] = idx;
   }
@@ -96,6 +99,7 @@ void FlatteningConverter::parseDefinition(
 
   palette[bid].name = flatname;
   palette[bid].hid  = qHash(palette[bid].name);
+  palette[bid].cid  = BlockIdentifier::Instance().getCompactId(palette[bid].hid);
   if ((parentID == NULL) && (data == 0)) {
     // spread main block type for data == 0
     // Spread values must be spaced by 4096 to not collide
@@ -104,6 +108,7 @@ void FlatteningConverter::parseDefinition(
       int sid = bid | (d<<12);
       palette[sid].name = flatname;
       palette[sid].hid  = palette[bid].hid;
+      palette[sid].cid  = palette[bid].cid;
     }
   }
   //  packs[pack].append(block);
@@ -131,6 +136,7 @@ void FlatteningConverter::parseDefinition(
       int mid = bid | ((j & mask) << 12);
       palette[id].name = palette[mid].name;
       palette[id].hid  = palette[mid].hid;
+      palette[id].cid  = palette[mid].cid;
     }
 
   }
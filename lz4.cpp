@@ -0,0 +1,155 @@
+#include <string.h>
+#include "lz4.h"
+
+static const int minMatch     = 4;
+static const int lastLiterals = 5;   // last bytes are always literals
+static const int mfLimit      = 12;  // no match may start within last bytes
+static const int maxOffset    = 65535;
+static const int hashLog      = 12;
+
+static inline quint32 read32(const uchar *p) {
+  quint32 value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline int hash4(quint32 sequence) {
+  return (sequence * 2654435761U) >> (32 - hashLog);
+}
+
+static inline uchar *writeLength(uchar *op, int length) {
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = length;
+  return op;
+}
+
+static inline uchar *writeLiterals(uchar *op, uchar *token, const uchar *literals, int length) {
+  if (length >= 15) {
+    *token = 15 << 4;
+    op = writeLength(op, length - 15);
+  } else {
+    *token = length << 4;
+  }
+  memcpy(op, literals, length);
+  return op + length;
+}
+
+QByteArray Lz4::compress(const uchar *src, int size) {
+  QByteArray result;
+  result.resize(size + size / 255 + 16);  // worst case: everything is a literal
+  uchar *op = reinterpret_cast<uchar*>(result.data());
+
+  const uchar *ip     = src;
+  const uchar *anchor = src;   // start of pending literals
+  const uchar *iend   = src + size;
+
+  if (size > mfLimit) {
+    int table[1 << hashLog];   // last position of each hashed sequence
+    memset(table, 0, sizeof(table));
+    const uchar *matchStartLimit = iend - mfLimit;
+    const uchar *matchEndLimit   = iend - lastLiterals;
+
+    while (ip < matchStartLimit) {
+      quint32 sequence = read32(ip);
+      int h = hash4(sequence);
+      const uchar *ref = src + table[h];
+      table[h] = ip - src;
+
+      if ((ref >= ip) || (ip - ref > maxOffset) || (read32(ref) != sequence)) {
+        ip++;
+        continue;
+      }
+
+      // extend match forward
+      const uchar *mp = ip + minMatch;
+      const uchar *rp = ref + minMatch;
+      while ((mp < matchEndLimit) && (*mp == *rp)) {
+        mp++;
+        rp++;
+      }
+
+      // emit sequence: literals, offset, match length
+      uchar *token = op++;
+      op = writeLiterals(op, token, anchor, ip - anchor);
+      int offset = ip - ref;
+      *op++ = offset & 0xff;
+      *op++ = offset >> 8;
+      int matchLength = (mp - ip) - minMatch;
+      if (matchLength >= 15) {
+        *token |= 15;
+        op = writeLength(op, matchLength - 15);
+      } else {
+        *token |= matchLength;
+      }
+
+      ip = anchor = mp;
+    }
+  }
+
+  // last sequence contains only literals
+  uchar *token = op++;
+  op = writeLiterals(op, token, anchor, iend - anchor);
+
+  result.resize(op - reinterpret_cast<uchar*>(result.data()));
+  return result;
+}
+
+bool Lz4::decompress(const QByteArray &src, uchar *dst, int size) {
+  const uchar *ip   = reinterpret_cast<const uchar*>(src.constData());
+  const uchar *iend = ip + src.size();
+  uchar *op   = dst;
+  uchar *oend = dst + size;
+
+  while (ip < iend) {
+    int token = *ip++;
+
+    // copy literals
+    int length = token >> 4;
+    if (length == 15) {
+      int s;
+      do {
+        if (ip >= iend) return false;
+        s = *ip++;
+        length += s;
+      } while (s == 255);
+    }
+    if ((length > iend - ip) || (length > oend - op)) return false;
+    memcpy(op, ip, length);
+    op += length;
+    ip += length;
+
+    if (ip >= iend) break;  // last sequence has no match
+
+    // copy match
+    if (iend - ip < 2) return false;
+    int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if ((offset == 0) || (offset > op - dst)) return false;
+
+    length = token & 15;
+    if (length == 15) {
+      int s;
+      do {
+        if (ip >= iend) return false;
+        s = *ip++;
+        length += s;
+      } while (s == 255);
+    }
+    length += minMatch;
+    if (length > oend - op) return false;
+
+    const uchar *ref = op - offset;
+    if (offset >= length) {
+      memcpy(op, ref, length);
+      op += length;
+    } else {
+      // overlapping copy repeats the pattern
+      while (length--) *op++ = *ref++;
+    }
+  }
+
+  return (op == oend);
+}
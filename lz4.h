@@ -0,0 +1,14 @@
+#ifndef LZ4_H_
+#define LZ4_H_
+
+#include <QByteArray>
+
+// minimal in-tree implementation of the LZ4 block format
+// used to keep cold data compressed in memory, favours speed over ratio
+class Lz4 {
+ public:
+  static QByteArray compress(const uchar *src, int size);
+  static bool       decompress(const QByteArray &src, uchar *dst, int size);  // size of uncompressed data must be known
+};
+
+#endif  // LZ4_H_
@@ -1,12 +1,16 @@
 /** Copyright (c) 2013, Sean Kasun */
 #include <QPainter>
+#include <QTimer>
 #include <QResizeEvent>
 #include <QMessageBox>
 #include <assert.h>
+#include <climits>
 
 #include "mapview.h"
 #include "chunkcache.h"
 #include "chunkrenderer.h"
+#include "renderqueue.h"
+#include "tilestore.h"
 #include "identifier/definitionmanager.h"
 #include "identifier/blockidentifier.h"
 #include "identifier/biomeidentifier.h"
@@ -18,14 +22,33 @@ MapView::MapView(QWidget *parent)
   , scale(1)      // overworld coordinate mapping
   , zoomIndex(0)  // 1:1
   , cache(ChunkCache::Instance())
+  , prefetcher(cache)
+  , tiles(TileCache::Instance())
+  , redrawPending(false)
+  , generation(0)
+  , composing(NULL)
+  , composePending(false)
+  , summaryDepth(INT_MIN)  // nothing summarized yet
+  , summaryScanFlags(0)
 {
+  presented.generation = -1;  // nothing composed yet
+  // a single composition at a time, stale frames are dropped anyway
+  composerPool.setMaxThreadCount(1);
   adjustZoom(0, false);
+  // all redraw requests and Chunk updates are coalesced into frames
+  frameTimer.setSingleShot(true);
+  frameTimer.setInterval(FRAME_INTERVAL);
+  frameTimer.setTimerType(Qt::PreciseTimer);
+  connect(&frameTimer, SIGNAL(timeout()),
+          this,        SLOT  (drawFrame()));
+  prefetcher.setBudget(QSettings().value("prefetchbudget", prefetcher.getBudget()).toInt());
   connect(&cache, SIGNAL(chunkLoaded(int, int)),
           this,   SLOT  (chunkUpdated(int, int)));
   connect(&cache, SIGNAL(structureFound(QSharedPointer<GeneratedStructure>)),
           this,   SLOT  (addStructureFromChunk(QSharedPointer<GeneratedStructure>)));
   setMouseTracking(true);
   setFocusPolicy(Qt::StrongFocus);
+  setAttribute(Qt::WA_OpaquePaintEvent);  // every pixel is painted from imageChunks
 
   int offset = 0;
   for (int y = 0; y < 16; y++)
@@ -57,7 +80,15 @@ QSize MapView::sizeHint() const {
 void MapView::attach(DefinitionManager *dm) {
   this->dm = dm;
   connect(dm, SIGNAL(packsChanged()),
-          this, SLOT(redraw()));
+          this, SLOT(definitionsChanged()));
+}
+
+void MapView::definitionsChanged() {
+  // rendered Tiles depend on the active definitions
+  tiles.clear();
+  pyramid.clear();
+  TileStore::Instance().setPath(cache.getPath(), dm->getDefinitionsHash());
+  redraw();
 }
 
 void MapView::setLocation(double x, double z) {
@@ -97,7 +128,12 @@ void MapView::setDimension(QString path, int scale) {
     this->z = 0;
   }
   cache.clear();
+  tiles.clear();
+  pyramid.clear();
+  entitySummaries.clear();
   cache.setPath(path);
+  TileStore::Instance().setPath(path, dm->getDefinitionsHash());
+  prefetcher.reset();
   redraw();
 }
 
@@ -118,9 +154,20 @@ int MapView::getDepth() const {
   return depth;
 }
 
+void MapView::setPrefetchBudget(int chunks) {
+  prefetcher.setBudget(chunks);
+}
+
 void MapView::chunkUpdated(int x, int z) {
-  drawChunk(x, z);
-  update();
+  // handled with the next frame, together with all other updates
+  updatedChunks.insert(ChunkID(x, z));
+  scheduleFrame();
+}
+
+void MapView::chunksRendered(QVector<QPoint> chunks) {
+  for (const QPoint &c : chunks)
+    updatedChunks.insert(ChunkID(c.x(), c.y()));
+  scheduleFrame();
 }
 
 QString MapView::getWorldPath() {
@@ -129,11 +176,18 @@ QString MapView::getWorldPath() {
 
 void MapView::updateSearchResultPositions(const QVector<QSharedPointer<OverlayItem> > &searchResults)
 {
-  currentSearchResults = searchResults;
+  currentSearchResults.clear();
+  for (auto &item : searchResults)
+    currentSearchResults.insert(item);
 }
 
 void MapView::clearCache() {
   cache.clear();
+  tiles.clear();
+  pyramid.clear();
+  entitySummaries.clear();
+  TileStore::Instance().clear();
+  prefetcher.reset();
   redraw();
 }
 
@@ -174,6 +228,9 @@ void MapView::adjustZoom(double steps, bool allowZoomOut)
 
   // we try to set higher margin than above (100%)!
   cache.setCacheMaxSize(2.0 * chunks);
+  // switching shading flags re-shades the whole view from G-buffers,
+  // they are small compared to Chunks (and limited to a share of them)
+  tiles.setGBufferMaxSize(std::min(2.0 * chunks, maxchunks / 2.0));
 }
 
 static int lastMouseX = -1, lastMouseY = -1;
@@ -198,15 +255,24 @@ void MapView::mouseMoveEvent(QMouseEvent *event) {
     int mx = floor(centerblockx - (centerx - event->x()) / zoom);
     int mz = floor(centerblockz - (centery - event->y()) / zoom);
 
-    getToolTip(mx, mz);
+    if (flags & flgCrossSection) {
+      // horizontal axis runs along the cut, vertical axis is Y with depth at the top
+      const bool alongX = flags & flgCrossSectionXY;
+      int mu   = floor((alongX ? this->x : this->z) + (event->x() - imageChunks.width() / 2) / zoom);
+      int mcut = floor(alongX ? this->z : this->x);
+      int my   = depth - floor(event->y() / zoom);
+      getToolTip(alongX ? mu : mcut, alongX ? mcut : mu, my);
+      return;
+    }
+    getToolTip(mx, mz, depth);
     return;
   }
-  x += (lastMouseX-event->x()) / zoom;
-  z += (lastMouseY-event->y()) / zoom;
+  int dx = lastMouseX - event->x();
+  int dy = lastMouseY - event->y();
   lastMouseX = event->x();
   lastMouseY = event->y();
 
-  redraw();
+  panView(dx, dy);
 }
 
 void MapView::mouseReleaseEvent(QMouseEvent * /* event */) {
@@ -214,6 +280,10 @@ void MapView::mouseReleaseEvent(QMouseEvent * /* event */) {
 }
 
 void MapView::mouseDoubleClickEvent(QMouseEvent *event) {
+  // item properties are only available in top-down view
+  if (flags & flgCrossSection)
+    return;
+
   int centerblockx = floor(this->x);
   int centerblockz = floor(this->z);
 
@@ -249,60 +319,60 @@ void MapView::wheelEvent(QWheelEvent *event) {
   } else if ((event->modifiers() & modifier4ZoomOut) == modifier4ZoomOut) {
     // allow change zoom also to zoom OUT
     adjustZoom( event->delta() / 120.0, true );
+    prefetcher.trackZoom( event->delta() / 120.0 );
     redraw();
   } else {
     // normal change zoom
     adjustZoom( event->delta() / 120.0, false );
+    prefetcher.trackZoom( event->delta() / 120.0 );
     redraw();
   }
 }
 
 void MapView::keyPressEvent(QKeyEvent *event) {
-  // default: 16 blocks / 1 chunk
-  float stepSize = 16.0;
+  // default: 16 blocks / 1 chunk (in pixels)
+  int stepSize = 16;
   bool allowZoomOut = false;
 
   if        ((event->modifiers() & Qt::ShiftModifier) == Qt::ShiftModifier) {
     // 1 block for fine tuning
-    stepSize = 1.0;
+    stepSize = 1;
   } else if ((event->modifiers() & Qt::AltModifier) == Qt::AltModifier) {
     // 8 chunks
-    stepSize = 128.0;
+    stepSize = 128;
   } else if ((event->modifiers() & Qt::ControlModifier) == Qt::ControlModifier) {
     // 32 chunks / 1 Region
-    stepSize = 512.0;
+    stepSize = 512;
     allowZoomOut = true;
   }
 
   switch (event->key()) {
     case Qt::Key_Up:
     case Qt::Key_W:
-      z -= stepSize / zoom;
-      redraw();
+      panView(0, -stepSize);
       break;
     case Qt::Key_Down:
     case Qt::Key_S:
-      z += stepSize / zoom;
-      redraw();
+      panView(0, stepSize);
       break;
     case Qt::Key_Left:
     case Qt::Key_A:
-      x -= stepSize / zoom;
-      redraw();
+      panView(-stepSize, 0);
       break;
     case Qt::Key_Right:
     case Qt::Key_D:
-      x += stepSize / zoom;
-      redraw();
+      panView(stepSize, 0);
       break;
     case Qt::Key_PageUp:
     case Qt::Key_Q:
       adjustZoom(1, allowZoomOut);
+      prefetcher.trackZoom(1);
       redraw();
       break;
     case Qt::Key_PageDown:
     case Qt::Key_E:
       adjustZoom(-1, allowZoomOut);
+      prefetcher.trackZoom(-1);
       redraw();
       break;
     case Qt::Key_Home:
@@ -319,30 +389,236 @@ void MapView::keyPressEvent(QKeyEvent *event) {
 }
 
 void MapView::resizeEvent(QResizeEvent *event) {
-  // adapt size of rendered images
+  // adapt size of rendered images, blank until the first frame is composed
   imageChunks   = QImage(event->size(), QImage::Format_RGB32);
   imageOverlays = QImage(event->size(), QImage::Format_RGBA8888);
+  imageChunks.fill(0xeeeeee);
+  imageOverlays.fill(0);
   // restrict zoom and adapt ChunkCache
   adjustZoom(0, true);
   // redraw everything
   redraw();
 }
 
-void MapView::paintEvent(QPaintEvent * /* event */) {
+void MapView::paintEvent(QPaintEvent *event) {
+  // only the dirty part of the view
   QPainter p(this);
-  p.drawImage(QPoint(0, 0), imageChunks);
-  p.drawImage(QPoint(0, 0), imageOverlays);
+  p.drawImage(event->rect(), imageChunks,   event->rect());
+  p.drawImage(event->rect(), imageOverlays, event->rect());
   p.end();
 }
 
+// request to draw the whole view again with the next frame
 void MapView::redraw() {
+  // frames in composition are stale from now on
+  generation++;
+  redrawPending = true;
+  scheduleFrame();
+}
+
+// request to pan the view by a pixel delta with the next frame
+void MapView::panView(int dx, int dy) {
+  panPending += QPoint(dx, dy);
+  scheduleFrame();
+}
+
+void MapView::scheduleFrame() {
+  if (!frameTimer.isActive())
+    frameTimer.start();
+}
+
+// flush everything requested since the last frame at once:
+// Chunk data and renders are requested on the GUI thread,
+// the frame itself is composed by a worker
+void MapView::drawFrame() {
+  const bool panned = !panPending.isNull();
+  if (panned) {
+    x += panPending.x() / zoom;
+    z += panPending.y() / zoom;
+    prefetcher.trackPan(panPending.x() / zoom, panPending.y() / zoom);
+    panPending = QPoint();
+  }
+  const bool full = redrawPending;
+  redrawPending = false;
+
   if (!this->isEnabled()) {
     // blank
+    updatedChunks.clear();
+    presented.generation = -1;
     imageChunks.fill(0xeeeeee);
+    imageOverlays.fill(0);
     update();
     return;
   }
 
+  // prefetched Chunks are rendered when they become visible
+  const QRect visible = getVisibleChunks();
+  if (flags & flgCrossSection) {
+    // cheap enough to be cut on the GUI thread
+    presented.generation = -1;
+    if (full || panned) {
+      redrawCrossSection();
+    } else if (!updatedChunks.isEmpty()) {
+      for (const ChunkID &id : updatedChunks)
+        if (visible.contains(id.getX(), id.getZ()))
+          drawCrossSection(id.getX(), id.getZ());
+      update();
+    }
+    updatedChunks.clear();
+    return;
+  }
+
+  // renders for another depth or scan, or for Chunks far off the view are not needed anymore
+  const QRect ring = visible.adjusted(-PRERENDER_RING, -PRERENDER_RING,
+                                      PRERENDER_RING, PRERENDER_RING);
+  if (full)
+    RenderQueue::Instance().cancelStale(ring, depth, flags);
+  else if (panned)
+    RenderQueue::Instance().cancelOutside(ring);
+
+  // Entity summaries depend on depth and the surface found by the scan
+  if ((summaryDepth != depth) || (summaryScanFlags != GBuffer::getScanFlags(flags))) {
+    summaryDepth     = depth;
+    summaryScanFlags = GBuffer::getScanFlags(flags);
+    entitySummaries.clear();
+  }
+
+  updateChunks(visible);
+  for (const ChunkID &id : updatedChunks) {
+    // keep Entity summaries for clustering, also when the Tile is evicted later,
+    // the marker of its cluster may be visible although the Tile is not
+    QSharedPointer<RenderedTile> tile(tiles.fetchCached(TileID(id.getX(), id.getZ(), depth, flags)));
+    if (tile && tile->hasEntities &&
+        (!tile->summary.isEmpty() || entitySummaries.contains(id))) {
+      if (tile->summary.isEmpty())
+        entitySummaries.remove(id);
+      else
+        entitySummaries.insert(id, tile->summary);
+      dirty += QRect(id.getX(), id.getZ(), 1, 1);
+    }
+    if (!visible.contains(id.getX(), id.getZ())) {
+      if (ring.contains(id.getX(), id.getZ()))
+        prerenderChunk(id.getX(), id.getZ());
+      continue;
+    }
+    updateChunk(id.getX(), id.getZ());
+    dirty += QRect(id.getX(), id.getZ(), 1, 1);
+  }
+  updatedChunks.clear();
+  submitRendering();
+  if (entitySummaries.size() > MAX_SUMMARIES)
+    pruneEntitySummaries(visible);
+
+  // queue Chunks that will probably become visible next
+  prefetcher.prefetch(visible);
+
+  if (!full && !panned && dirty.isEmpty() && (presented.generation == generation))
+    return;  // only invisible Chunks changed
+
+  emit(coordinatesChanged(x, depth, z));
+
+  composePending = true;
+  composeFrame();
+}
+
+ViewState MapView::getViewState() const {
+  ViewState state;
+  state.x          = x;
+  state.z          = z;
+  state.zoom       = zoom;
+  state.depth      = depth;
+  state.flags      = flags;
+  state.size       = imageChunks.size();
+  state.generation = generation;
+  return state;
+}
+
+// hand the current view state to the composer, unless it is still busy
+void MapView::composeFrame() {
+  if (composing || !composePending)
+    return;
+  composePending = false;
+
+  const ViewState state = getViewState();
+  composing = new ViewComposer(state);
+  composing->setBase(presented, imageChunks, imageOverlays, dirty);
+  dirty = QRegion();
+
+  // shallow copies, the atlas images detach when updated meanwhile
+  const QRect chunks = state.getChunksIn(QRect(QPoint(0, 0), state.size));
+  const int level = state.getLevel();
+  QHash<ChunkID, QImage> regions;
+  quint32 present[32];
+  for (int rz = chunks.top() >> 5; rz <= chunks.bottom() >> 5; rz++)
+    for (int rx = chunks.left() >> 5; rx <= chunks.right() >> 5; rx++)
+      regions.insert(ChunkID(rx, rz), pyramid.fetch(rx, rz, depth, flags, level, present));
+  composing->setRegions(regions);
+  composing->setOverlays(overlayItemTypes, overlayItems, currentSearchResults);
+  composing->setEntitySummaries(entitySummaries);
+
+  connect(composing, SIGNAL(composed()),
+          this,      SLOT  (frameComposed()), Qt::QueuedConnection);
+  composerPool.start(composing);
+}
+
+// present a composed frame, unless the view changed too much meanwhile
+void MapView::frameComposed() {
+  ViewComposer *frame = composing;
+  composing = NULL;
+  const ViewState &state = frame->getState();
+  if ((state.generation == generation) && !(flags & flgCrossSection) && this->isEnabled()) {
+    imageChunks   = frame->getChunks();
+    imageOverlays = frame->getOverlays();
+    // shift what is on screen already, repaint only the parts drawn anew
+    const ViewState &base = frame->getBaseState();
+    if (frame->isIncremental() && (presented.generation == base.generation) &&
+        (presented.x == base.x) && (presented.z == base.z)) {
+      const QPoint shift = frame->getShift();
+      if (!shift.isNull())
+        scroll(-shift.x(), -shift.y());
+      update(frame->getComposed());
+    } else {
+      update();
+    }
+    presented = state;
+  }
+  frame->deleteLater();
+
+  // compose what changed in the meantime
+  composeFrame();
+}
+
+// vertical cut through the world at the current view position
+void MapView::redrawCrossSection() {
+  const QRect visible = getVisibleChunks();
+  for (int cz = visible.top(); cz <= visible.bottom(); cz++)
+    for (int cx = visible.left(); cx <= visible.right(); cx++)
+      drawCrossSection(cx, cz);
+
+  // queue Chunks that will probably become visible next
+  prefetcher.prefetch(visible);
+
+  // overlays are only available in top-down view
+  imageOverlays.fill(0);
+
+  emit(coordinatesChanged(x, depth, z));
+
+  update();
+}
+
+// area of Chunks that are (at least partially) visible, in Chunk coordinates
+QRect MapView::getVisibleChunks() const {
+  if (flags & flgCrossSection) {
+    // only one row of Chunks along the cut
+    const bool alongX = flags & flgCrossSectionXY;
+    const double u = alongX ? x : z;
+    int first = floor((u - imageChunks.width() / 2 / zoom) / 16);
+    int last  = floor((u + imageChunks.width() / 2 / zoom) / 16);
+    int cut   = floor((alongX ? z : x) / 16);
+    return alongX ? QRect(first, cut, last - first + 1, 1)
+                  : QRect(cut, first, 1, last - first + 1);
+  }
+
   double chunksize = 16 * zoom;
 
   // first find the center block position
@@ -361,129 +637,171 @@ void MapView::redraw() {
   int blockswide = imageChunks.width() / chunksize + 3;
   int blockstall = imageChunks.height() / chunksize + 3;
 
-  for (int cz = startz; cz < startz + blockstall; cz++)
-    for (int cx = startx; cx < startx + blockswide; cx++)
-      drawChunk(cx, cz);
-
-  // clear the overlay layer
-  imageOverlays.fill(0);
+  return QRect(startx, startz, blockswide, blockstall);
+}
 
-  // add on the entity layer
-  QPainter canvas(&imageOverlays);
-  double halfviewwidth  = imageOverlays.width() / 2 / zoom;
-  double halvviewheight = imageOverlays.height() / 2 / zoom;
-  double x1 = x - halfviewwidth;
-  double z1 = z - halvviewheight;
-  double x2 = x + halfviewwidth;
-  double z2 = z + halvviewheight;
-
-  // draw the entities
-  for (int cz = startz; cz < startz + blockstall; cz++) {
-    for (int cx = startx; cx < startx + blockswide; cx++) {
-      QSharedPointer<Chunk> chunk(cache.fetch(cx, cz));
-      if (chunk) {
-        // Entities from Chunks
-        for (auto &type : overlayItemTypes) {
-          auto range = chunk->entities.equal_range(type);
-          for (auto it = range.first; it != range.second; ++it) {
-            // don't show entities above our depth
-            int entityY = (*it)->midpoint().y;
-            // everything below the current block,
-            // but also inside the current block
-            if (entityY < depth + 1) {
-              int entityX = static_cast<int>((*it)->midpoint().x) & 0x0f;
-              int entityZ = static_cast<int>((*it)->midpoint().z) & 0x0f;
-              int index = entityX + (entityZ << 4);
-              int highY = chunk->depth[index];
-              if ( (entityY+10 >= highY) ||
-                   (entityY+10 >= depth) )
-                (*it)->draw(x1, z1, zoom, &canvas);
-            }
-          }
-        }
+// copy the rendered image of one Chunk into its Region atlas,
+// rendering is started when no image is available for current depth and flags
+void MapView::updateChunk(int x, int z) {
+  if (!this->isEnabled())
+    return;
 
-      }
+  // an already rendered Tile does not need the Chunk data
+  QSharedPointer<RenderedTile> tile(tiles.fetchCached(TileID(x, z, depth, flags)));
+  QSharedPointer<Chunk> chunk;
+
+  if (!tile) {
+    if (startShading(x, z, RenderQueue::prioVisible))
+      return;
+    // fetch the chunk
+    prefetcher.markVisible(x, z);
+    chunk = cache.fetch(x, z);
+    if (!chunk) return;  // atlas keeps showing the placeholder
+    if (!chunk->loaded) return;
+
+    if (chunk->rendering) {
+      // might be queued as prefetch only
+      RenderQueue::Instance().promote(x, z, RenderQueue::prioVisible);
+      return;
     }
   }
 
-  const OverlayItem::Cuboid viewingCuboid(OverlayItem::Point(x1 - 1, -4096, z1 - 1),
-                                          OverlayItem::Point(x2 + 1, depth, z2 + 1));
-
-  // draw the generated structures
-  for (auto &type : overlayItemTypes) {
-    drawOverlayItems(overlayItems[type], viewingCuboid, x1, z1, canvas);
+  if (chunk && (chunk->renderedAt != depth ||
+                chunk->renderedFlags != flags)) {
+    startRendering(x, z, chunk, RenderQueue::prioVisible);
+    return;
   }
 
-  drawOverlayItems(currentSearchResults, viewingCuboid, x1, z1, canvas);
-
-  emit(coordinatesChanged(x, depth, z));
-
-  update();
+  const uchar* srcImageData = tile ? tile->image : chunk->getImage();
+  pyramid.insert(TileID(x, z, depth, flags), srcImageData, TilePyramid::getLevel(zoom));
 }
 
+// render a loaded Chunk close to the view ahead of time
+void MapView::prerenderChunk(int x, int z) {
+  if (tiles.fetchCached(TileID(x, z, depth, flags)))
+    return;  // already rendered
+  if (startShading(x, z, RenderQueue::prioPrefetch))
+    return;
+  QSharedPointer<Chunk> chunk(cache.fetchCached(x, z));
+  if (!chunk || !chunk->loaded || chunk->rendering)
+    return;
+  if ((chunk->renderedAt != depth) || (chunk->renderedFlags != flags))
+    startRendering(x, z, chunk, RenderQueue::prioPrefetch);
+}
+
+// shade the G-buffer of an earlier render again, when only shading flags changed,
+// or load the Tile of a previous session, both off the GUI thread
+// false when the Chunk has to be rendered from its Block data
+bool MapView::startShading(int x, int z, RenderQueue::Priority priority) {
+  switch (tiles.requestShade(TileID(x, z, depth, flags))) {
+    case TileCache::ShadeState::queue:
+      startRendering(x, z, QSharedPointer<Chunk>(), priority);
+      return true;
+    case TileCache::ShadeState::pending:
+      RenderQueue::Instance().promote(x, z, priority);
+      return true;
+    case TileCache::ShadeState::render:
+      break;
+  }
+  return false;
+}
+
+// collect Chunks to render in batches of neighboring Chunks,
+// chunk is NULL when only a G-buffer is shaded
+void MapView::startRendering(int x, int z, const QSharedPointer<Chunk> &chunk,
+                             RenderQueue::Priority priority) {
+  if (chunk)
+    chunk->rendering = true;  // cleared by the renderer
+  const ChunkID id(RenderQueue::getBatch(x, z));
+  auto it = renderBatches.find(id);
+  if (it == renderBatches.end()) {
+    renderBatches.insert(id, { new ChunkRenderer(x, z, depth, flags), priority });
+  } else {
+    it->renderer->add(x, z);
+    it->priority = std::max(it->priority, priority);
+  }
+}
 
-template<typename ListT>
-void MapView::drawOverlayItems(const ListT &list, const OverlayItem::Cuboid& cuboid, double x1, double z1, QPainter& canvas)
-{
-  for (auto &item : list) {
-    if (item->intersects(cuboid)) {
-      item->draw(x1, z1, zoom, &canvas);
+// queue all batches collected during this frame
+void MapView::submitRendering() {
+  RenderQueue &queue = RenderQueue::Instance();
+  for (auto it = renderBatches.begin(); it != renderBatches.end(); ++it) {
+    connect(it->renderer, SIGNAL(rendered(QVector<QPoint>)),
+            this,         SLOT(chunksRendered(QVector<QPoint>)));
+    queue.render(it.key(), it->renderer, it->priority);
+  }
+  renderBatches.clear();
+}
+
+// get rendered images of all Chunks not yet in their Region atlas
+void MapView::updateChunks(const QRect &chunks) {
+  const int level = TilePyramid::getLevel(zoom);
+  quint32 present[32];
+  for (int rz = chunks.top() >> 5; rz <= chunks.bottom() >> 5; rz++) {
+    for (int rx = chunks.left() >> 5; rx <= chunks.right() >> 5; rx++) {
+      pyramid.fetch(rx, rz, depth, flags, level, present);
+      const QRect area = chunks & QRect(rx * 32, rz * 32, 32, 32);
+      for (int cz = area.top(); cz <= area.bottom(); cz++)
+        for (int cx = area.left(); cx <= area.right(); cx++)
+          if (!(present[cz & 0x1f] & (1u << (cx & 0x1f))))
+            updateChunk(cx, cz);
     }
   }
 }
 
-void MapView::drawChunk(int x, int z) {
+// forget Entity summaries further off the view than one view size,
+// they are collected again when their Chunks are rendered
+void MapView::pruneEntitySummaries(const QRect &visible) {
+  const QRect keep = visible.adjusted(-visible.width(), -visible.height(),
+                                      visible.width(), visible.height());
+  for (auto it = entitySummaries.begin(); it != entitySummaries.end(); ) {
+    if (keep.contains(it.key().getX(), it.key().getZ()))
+      ++it;
+    else
+      it = entitySummaries.erase(it);
+  }
+}
+
+// draw the Chunk column of a vertical cut, Blocks at depth are at the top of the view
+void MapView::drawCrossSection(int cx, int cz) {
   if (!this->isEnabled())
     return;
 
-  // fetch the chunk
-  QSharedPointer<Chunk> chunk(cache.fetch(x, z));
-  if (chunk && !chunk->loaded) return;
-
-  if (chunk && chunk->rendering) return;
-
-  if (chunk && (chunk->renderedAt != depth ||
-                chunk->renderedFlags != flags)) {
-    //renderChunk(chunk);
-    chunk->rendering = true;
-    ChunkRenderer *renderer = new ChunkRenderer(x, z, depth, flags);
-    connect(renderer, &ChunkRenderer::rendered,
-            [chunk](int, int) { chunk->rendering = false; });
-    connect(renderer, SIGNAL(rendered(int, int)),
-            this,     SLOT(chunkUpdated(int, int)));
-    QThreadPool::globalInstance()->start(renderer);
-    return;
-  }
+  const bool alongX = flags & flgCrossSectionXY;
+  const int  cu     = alongX ? cx : cz;
+  const int  pos    = static_cast<int>(floor(alongX ? this->z : this->x)) & 0x0f;
+  const SectionSlice::Axis axis = alongX ? SectionSlice::axisZ : SectionSlice::axisX;
 
-  // this figures out where on the screen this chunk should be drawn
-
-  // first find the center chunk
-  int centerchunkx = floor(this->x / 16);
-  int centerchunkz = floor(this->z / 16);
-  // and the center chunk screen coordinates
-  double centerx = imageChunks.width() / 2;
-  double centery = imageChunks.height() / 2;
-  // which need to be shifted to account for panning inside that chunk
-  centerx -= (this->x - centerchunkx * 16) * zoom;
-  centery -= (this->z - centerchunkz * 16) * zoom;
-  // centerx,y now points to the top left corner of the center chunk
-  // so now calculate our x,y in relation
   double chunksize = 16 * zoom;
-  centerx += (x - centerchunkx) * chunksize;
-  centery += (z - centerchunkz) * chunksize;
+  double left = imageChunks.width() / 2 + (cu * 16 - (alongX ? this->x : this->z)) * zoom;
+  QRectF column(left, 0, chunksize, imageChunks.height());
 
-  const uchar* srcImageData = chunk ? chunk->getImage() : placeholder;
-  QImage srcImage(srcImageData, 16, 16, QImage::Format_RGB32);
-
-  QRectF targetRect(centerx, centery, chunksize, chunksize);
+  prefetcher.markVisible(cx, cz);
+  QSharedPointer<Chunk> chunk(cache.fetch(cx, cz));
+  if (chunk && !chunk->loaded) return;
 
   QPainter canvas(&imageChunks);
   if (this->zoom < 1.0)
       canvas.setRenderHint(QPainter::SmoothPixmapTransform);
-  canvas.drawImage(targetRect, srcImage);
+  if (!chunk) {
+    canvas.drawImage(column, QImage(placeholder, 16, 16, QImage::Format_RGB32));
+    return;
+  }
+  canvas.fillRect(column, Qt::black);
+
+  // Section slabs are cheap enough to be cut on every redraw
+  const int bottom = depth - static_cast<int>(imageChunks.height() / zoom);
+  const int topSection    = std::min(depth,  chunk->highest) >> 4;
+  const int bottomSection = std::max(bottom, chunk->lowest)  >> 4;
+  uchar image[16 * 16 * 4];
+  for (int sec = topSection; sec >= bottomSection; sec--) {
+    ChunkRenderer::renderCrossSection(*chunk, sec, axis, pos, image);
+    QRectF targetRect(left, (depth + 1 - (sec + 1) * 16) * zoom, chunksize, chunksize);
+    canvas.drawImage(targetRect, QImage(image, 16, 16, QImage::Format_RGB32));
+  }
 }
 
-void MapView::getToolTip(int x, int z) {
+void MapView::getToolTip(int x, int z, int maxY) {
   int cx = floor(x / 16.0);
   int cz = floor(z / 16.0);
   QSharedPointer<Chunk> chunk(cache.fetch(cx, cz));
@@ -496,7 +814,7 @@ void MapView::getToolTip(int x, int z) {
   QMap<QString, int> entityIds;
 
   if ((chunk) && (chunk->highest >= chunk->lowest)) {
-    int top = std::min(depth, chunk->highest);
+    int top = std::min(maxY, chunk->highest);
     for (y = top; y >= chunk->lowest; y--) {
       const ChunkSection *section = chunk->getSectionByY(y);
       if (!section) {
@@ -578,8 +896,23 @@ void MapView::getToolTip(int x, int z) {
 #if defined(DEBUG) || defined(_DEBUG) || defined(QT_DEBUG)
   hovertext += " [Cache:"
             + QString().number(this->cache.getCacheUsage()) + "/"
-            + QString().number(this->cache.getCacheMax()) + "]";
+            + QString().number(this->cache.getCacheMax()) + " + "
+            + QString().number(this->cache.getCompressedUsage()) + "/"
+            + QString().number(this->cache.getCompressedMax()) + "KB + "
+            + QString().number(this->cache.getSpillUsage()) + "/"
+            + QString().number(this->cache.getSpillMax()) + "MB]";
+  hovertext += " [Tiles:"
+            + QString().number(this->tiles.getCacheUsage()) + "/"
+            + QString().number(this->tiles.getCacheMax()) + " G-buffer:"
+            + QString().number(this->tiles.getGBufferUsage()) + "/"
+            + QString().number(this->tiles.getGBufferMax()) + "KB Pyramid:"
+            + QString().number(this->pyramid.getUsage()) + "/"
+            + QString().number(this->pyramid.getMax()) + "KB]";
   hovertext += " Zoom:" + QString().number(zoomIndex);
+  hovertext += " [Prefetch:"
+            + QString().number(this->prefetcher.getHits()) + " hit/"
+            + QString().number(this->prefetcher.getMisses()) + " miss/"
+            + QString().number(this->prefetcher.getWasted()) + " wasted]";
 #endif
 
   emit hoverTextChanged(hovertext);
@@ -593,15 +926,8 @@ void MapView::addStructureFromChunk(QSharedPointer<GeneratedStructure> structure
 }
 
 void MapView::addOverlayItem(QSharedPointer<OverlayItem> item) {
-  // test if item is already in list
-  for (auto &it: overlayItems[item->type()]) {
-    OverlayItem::Point p1 = it  ->midpoint();
-    OverlayItem::Point p2 = item->midpoint();
-    if ( (p1.x == p2.x) && (p1.y == p2.y) && (p1.z == p2.z) )
-      return;  // skip if already present
-  }
-  // otherwise add item
-  overlayItems[item->type()].push_back(item);
+  // skipped if an item at the same position is already present
+  overlayItems[item->type()].insert(item);
 }
 
 void MapView::clearOverlayItems() {
@@ -629,14 +955,11 @@ QList<QSharedPointer<OverlayItem>> MapView::getItems(int x, int y, int z) {
     double invzoom = 10.0 / zoom;
     for (auto &type : overlayItemTypes) {
       // generated structures
-      for (auto &item : overlayItems[type]) {
-        double ymin = chunk->lowest;
-        double ymax = depth;
-        if (item->intersects(OverlayItem::Point(x, ymin, z),
-                             OverlayItem::Point(x, ymax, z))) {
-          ret.append(item);
-        }
-      }
+      double ymin = chunk->lowest;
+      double ymax = depth;
+      ret.append(overlayItems.value(type).query(
+          OverlayItem::Cuboid(OverlayItem::Point(x, ymin, z),
+                              OverlayItem::Point(x, ymax, z))));
 
       // entities
       auto itemRange = chunk->entities.equal_range(type);
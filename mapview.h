@@ -4,10 +4,18 @@
 
 #include <QtWidgets/QWidget>
 #include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
 #include "chunkcache.h"
+#include "chunkprefetcher.h"
+#include "renderqueue.h"
+#include "tilecache.h"
+#include "tilepyramid.h"
+#include "viewcomposer.h"
 
 class DefinitionManager;
 class BiomeIdentifier;
+class ChunkRenderer;
 class BlockIdentifier;
 class OverlayItem;
 
@@ -23,7 +31,10 @@ class MapView : public QWidget {
     flgDepthShading = 1 << 3,
     flgBiomeColors  = 1 << 4,
     flgSeaGround    = 1 << 5,
-    flgSingleLayer  = 1 << 6
+    flgSingleLayer  = 1 << 6,
+    flgCrossSectionXY = 1 << 7,  // vertical cut along X at current Z
+    flgCrossSectionZY = 1 << 8,  // vertical cut along Z at current X
+    flgCrossSection   = flgCrossSectionXY | flgCrossSectionZY
   };
 
   typedef struct {
@@ -48,6 +59,7 @@ class MapView : public QWidget {
   void setFlags(int flags);
   int  getFlags() const;
   int  getDepth() const;
+  void setPrefetchBudget(int chunks);  // 0 disables prefetching
   void addOverlayItem(QSharedPointer<OverlayItem> item);
   void clearOverlayItems();
   void setVisibleOverlayItemTypes(const QSet<QString>& itemTypes);
@@ -61,6 +73,7 @@ class MapView : public QWidget {
  public slots:
   void setDepth(int depth);
   void chunkUpdated(int x, int z);
+  void chunksRendered(QVector<QPoint> chunks);
   void redraw();
 
   // Clears the cache and redraws, causing all chunks to be re-loaded;
@@ -87,17 +100,31 @@ class MapView : public QWidget {
 
  private slots:
   void addStructureFromChunk(QSharedPointer<GeneratedStructure> structure);
+  void definitionsChanged();
+  void drawFrame();
+  void frameComposed();
 
  private:
-  void drawChunk(int x, int z);
-  void getToolTip(int x, int z);
+  ViewState getViewState() const;
+  QRect getVisibleChunks() const;
+  void updateChunk(int x, int z);
+  void prerenderChunk(int x, int z);
+  bool startShading(int x, int z, RenderQueue::Priority priority);
+  void startRendering(int x, int z, const QSharedPointer<Chunk> &chunk,
+                      RenderQueue::Priority priority);
+  void submitRendering();
+  void updateChunks(const QRect &chunks);
+  void pruneEntitySummaries(const QRect &visible);
+  void scheduleFrame();
+  void composeFrame();
+  void panView(int dx, int dy);
+  void redrawCrossSection();
+  void drawCrossSection(int cx, int cz);
+  void getToolTip(int x, int z, int maxY);
   int getY(int x, int z);
   QList<QSharedPointer<OverlayItem>> getItems(int x, int y, int z);
   void adjustZoom(double steps, bool allowZoomOut);
 
-  template<typename ListT>
-  void drawOverlayItems(const ListT& list, const OverlayItem::Cuboid& cuboid, double x1, double z1, QPainter& canvas);
-
   static const int CAVE_DEPTH = 16;  // maximum depth caves are searched in cave mode
   float caveshade[CAVE_DEPTH];
 
@@ -108,15 +135,38 @@ class MapView : public QWidget {
   double zoom;
   int flags;
   ChunkCache &cache;
+  ChunkPrefetcher prefetcher;
+  TileCache &tiles;
+  TilePyramid pyramid;
+  static const int FRAME_INTERVAL = 16;  // ms, about 60 frames per second
+  static const int PRERENDER_RING = 2;   // Chunks around the view rendered ahead
+  static const int MAX_SUMMARIES  = 65536;  // Entity summaries kept before pruning
+  QTimer frameTimer;              // flushes all pending changes once per frame
+  bool redrawPending;             // whole view has to be drawn again
+  QPoint panPending;              // accumulated pan delta in pixels
+  QSet<ChunkID> updatedChunks;    // loaded or rendered since last frame
+  struct RenderBatch {
+    ChunkRenderer *renderer;
+    RenderQueue::Priority priority;
+  };
+  QHash<ChunkID, RenderBatch> renderBatches;  // Chunks to render collected during a frame
+  QRegion dirty;                  // updated Chunks waiting for composition, in Chunk coordinates
+  int generation;                 // increased whenever composed frames become stale
+  QThreadPool composerPool;       // composition runs beside the Chunk rendering
+  ViewComposer *composing;        // frame in composition, one at a time
+  bool composePending;            // view changed while composing
+  ViewState presented;            // state of the frame shown
   QImage imageChunks;
   QImage imageOverlays;
   DefinitionManager *dm;
   uchar placeholder[16 * 16 * 4];  // no chunk found placeholder
   QSet<QString> overlayItemTypes;
-  QMap<QString, QList<QSharedPointer<OverlayItem>>> overlayItems;
+  ViewComposer::OverlayMap overlayItems;  // per type, indexed by position
+  QHash<ChunkID, EntitySummary> entitySummaries;  // of rendered Tiles with visible Entities
+  int summaryDepth, summaryScanFlags;              // view the summaries were made for
   BlockLocation currentLocation;
 
-  QVector<QSharedPointer<OverlayItem> > currentSearchResults;
+  OverlayIndex currentSearchResults;
 };
 
 #endif  // MAPVIEW_H_
@@ -30,6 +30,7 @@
 #include "overlay/village.h"
 #include "jumpto.h"
 #include "pngexport.h"
+#include "renderqueue.h"
 #include "search/searchchunkswidget.h"
 #include "search/searchentitypluginwidget.h"
 #include "search/searchblockpluginwidget.h"
@@ -38,6 +39,7 @@
 Minutor::Minutor()
 {
   m_ui.setupUi(this);
+  exportPool.setMaxThreadCount(1);
 
   // central MapView wiget
   mapview = new MapView;
@@ -59,6 +61,10 @@ Minutor::Minutor()
   dialogSettings = new Settings(this);
   connect(dialogSettings, SIGNAL(settingsUpdated()),
           this, SLOT(rescanWorlds()));
+  connect(dialogSettings, &Settings::cacheSettingsChanged,
+          [this]() { RenderQueue::Instance().setThreadCount(dialogSettings->renderThreads); });
+  connect(dialogSettings, &Settings::cacheSettingsChanged,
+          [this]() { mapview->setPrefetchBudget(dialogSettings->prefetchBudget); });
 
   // "Jump To" dialog
   dialogJumpTo = new JumpTo(this);
@@ -124,6 +130,8 @@ Minutor::Minutor()
 Minutor::~Minutor() {
   // wait for sheduled tasks
   QThreadPool::globalInstance()->waitForDone();
+  exportPool.waitForDone();
+  RenderQueue::Instance().waitForDone();
 }
 
 
@@ -206,7 +214,8 @@ void Minutor::savePNG(QString filename, bool autoclose,
             this, SLOT(saveProgress(QString, double)));
     connect(ws, SIGNAL(finished()),
             this, SLOT(saveFinished()));
-    QThreadPool::globalInstance()->start(ws);
+    // not on the RenderQueue, which would lose a thread for the whole export
+    exportPool.start(ws);
   }
 }
 
@@ -316,6 +325,8 @@ void Minutor::toggleFlags() {
   if (m_ui.action_BiomeColors->isChecked())  flags |= MapView::flgBiomeColors;
   if (m_ui.action_SeaGround->isChecked())    flags |= MapView::flgSeaGround;
   if (m_ui.action_SingleLayer->isChecked())  flags |= MapView::flgSingleLayer;
+  if (m_ui.action_CrossSectionXY->isChecked()) flags |= MapView::flgCrossSectionXY;
+  if (m_ui.action_CrossSectionZY->isChecked()) flags |= MapView::flgCrossSectionZY;
   mapview->setFlags(flags);
 
   QSet<QString> overlayTypes;
@@ -438,6 +449,18 @@ void Minutor::createActions() {
   connect(m_ui.action_SingleLayer, SIGNAL(triggered()),
           this,                    SLOT(toggleFlags()));
 
+  // both cross sections are exclusive
+  connect(m_ui.action_CrossSectionXY, &QAction::triggered,
+          [this](bool checked) {
+            if (checked) m_ui.action_CrossSectionZY->setChecked(false);
+            toggleFlags();
+          });
+  connect(m_ui.action_CrossSectionZY, &QAction::triggered,
+          [this](bool checked) {
+            if (checked) m_ui.action_CrossSectionXY->setChecked(false);
+            toggleFlags();
+          });
+
   // [View->Others]
 //  m_ui.action_Refresh->setStatusTip(tr("Reloads all chunks, "
 //                                       "but keeps the same position / dimension"));
@@ -7,6 +7,7 @@
 #include <QVariant>
 #include <QSharedPointer>
 #include <QSet>
+#include <QThreadPool>
 #include <QVector3D>
 #include <QtNetwork/QNetworkReply>
 #include <QWidgetAction>
@@ -111,6 +112,7 @@ signals:
   LabelledSlider *depth;
   QProgressDialog *progress;
   bool progressAutoclose;
+  QThreadPool exportPool;  // PNG export runs beside the map rendering
 
   QList<QAction*> worldActions;
   QList<QAction*> playerActions;
@@ -19,10 +19,14 @@ HEADERS += \
     labelledseparator.h \
     labelledslider.h \
     clamp.h \
+    compressedchunk.h \
     chunk.h \
     chunkcache.h \
     chunkloader.h \
+    chunkprefetcher.h \
     chunkrenderer.h \
+    chunkspill.h \
+    gbuffer.h \
     identifier/biomeidentifier.h \
     identifier/blockidentifier.h \
     identifier/definitionmanager.h \
@@ -32,19 +36,23 @@ HEADERS += \
     identifier/flatteningconverter.h \
     jumpto.h \
     json/json.h \
+    lz4.h \
     mapview.h \
     minutor.h \
     nbt/nbt.h \
     nbt/tag.h \
     nbt/tagdatastream.h \
     overlay/entity.h \
+    overlay/entitycluster.h \
     overlay/generatedstructure.h \
+    overlay/overlayindex.h \
     overlay/overlayitem.h \
     overlay/properties.h \
     overlay/propertietreecreator.h \
     overlay/village.h \
     paletteentry.h \
     pngexport.h \
+    renderqueue.h \
     search/entityevaluator.h \
     search/range.h \
     search/rectangleinnertoouteriterator.h \
@@ -54,7 +62,15 @@ HEADERS += \
     search/searchplugininterface.h \
     search/searchresultwidget.h \
     search/searchtextwidget.h \
+    sectionslice.h \
     settings.h \
+    shading.h \
+    spawnmask.h \
+    surfaceindex.h \
+    tilecache.h \
+    tilepyramid.h \
+    tilestore.h \
+    viewcomposer.h \
     worldinfo.h \
     worldsave.h \
     zipreader.h
@@ -64,7 +80,11 @@ SOURCES += \
     chunk.cpp \
     chunkcache.cpp \
     chunkloader.cpp \
+    chunkprefetcher.cpp \
     chunkrenderer.cpp \
+    chunkspill.cpp \
+    compressedchunk.cpp \
+    gbuffer.cpp \
     identifier/biomeidentifier.cpp \
     identifier/blockidentifier.cpp \
     identifier/definitionmanager.cpp \
@@ -74,6 +94,7 @@ SOURCES += \
     identifier/flatteningconverter.cpp \
     jumpto.cpp \
     json/json.cpp \
+    lz4.cpp \
     main.cpp \
     mapview.cpp \
     minutor.cpp \
@@ -81,18 +102,29 @@ SOURCES += \
     nbt/tag.cpp \
     nbt/tagdatastream.cpp \
     overlay/entity.cpp \
+    overlay/entitycluster.cpp \
     overlay/generatedstructure.cpp \
+    overlay/overlayindex.cpp \
     overlay/properties.cpp \
     overlay/propertietreecreator.cpp \
     overlay/village.cpp \
     pngexport.cpp \
+    renderqueue.cpp \
     search/entityevaluator.cpp \
     search/searchblockpluginwidget.cpp \
     search/searchchunkswidget.cpp \
     search/searchentitypluginwidget.cpp \
     search/searchresultwidget.cpp \
     search/searchtextwidget.cpp \
+    sectionslice.cpp \
     settings.cpp \
+    shading.cpp \
+    spawnmask.cpp \
+    surfaceindex.cpp \
+    tilecache.cpp \
+    tilepyramid.cpp \
+    tilestore.cpp \
+    viewcomposer.cpp \
     worldinfo.cpp \
     worldsave.cpp \
     zipreader.cpp
@@ -1,5 +1,7 @@
 /** Copyright 2014 EtlamGit */
+#include <QDataStream>
 #include <QPainter>
+#include <algorithm>
 
 #include "overlay/entity.h"
 #include "identifier/entityidentifier.h"
@@ -133,3 +135,46 @@ void Entity::draw(double offsetX, double offsetZ, double scale,
 Entity::Point Entity::midpoint() const {
   return pos;
 }
+
+Entity::Cuboid Entity::bounds() const {
+  // lines to POI locations are part of the drawing
+  Cuboid box(pos, pos);
+  foreach( POI p, poiList ) {
+    box.min.x = std::min(box.min.x, p.x + 0.5);
+    box.min.z = std::min(box.min.z, p.z + 0.5);
+    box.max.x = std::max(box.max.x, p.x + 0.5);
+    box.max.z = std::max(box.max.z, p.z + 0.5);
+  }
+  return box;
+}
+
+void Entity::write(QDataStream &stream) const {
+  stream << pos.x << pos.y << pos.z << extraColor
+         << type() << OverlayItem::display() << color() << dimension() << properties();
+  stream << poiList.size();
+  for (const POI &p : poiList)
+    stream << p.x << p.z << p.color;
+}
+
+QSharedPointer<OverlayItem> Entity::read(QDataStream &stream) {
+  Entity *entity = new Entity();
+  QString type, display, dimension;
+  QColor color;
+  QVariant props;
+  stream >> entity->pos.x >> entity->pos.y >> entity->pos.z >> entity->extraColor
+         >> type >> display >> color >> dimension >> props;
+  entity->setType(type);
+  entity->setDisplay(display);
+  entity->setColor(color);
+  entity->setDimension(dimension);
+  entity->setProperties(props);
+
+  int count = 0;
+  stream >> count;
+  for (int i = 0; (i < count) && (stream.status() == QDataStream::Ok); i++) {
+    POI p;
+    stream >> p.x >> p.z >> p.color;
+    entity->poiList.append(p);
+  }
+  return QSharedPointer<OverlayItem>(entity);
+}
@@ -5,6 +5,7 @@
 #include <QSharedPointer>
 #include "overlay/overlayitem.h"
 
+class QDataStream;
 class Tag;
 
 class Entity: public OverlayItem {
@@ -12,11 +13,15 @@ class Entity: public OverlayItem {
   explicit Entity(const Point& positionInfo);
 
   static QSharedPointer<OverlayItem> TryParse(const Tag* tag);
+  // binary form for the disk tier of the ChunkCache
+  void write(QDataStream &stream) const;
+  static QSharedPointer<OverlayItem> read(QDataStream &stream);
 
   virtual bool intersects(const OverlayItem::Cuboid& cuboid) const;
   virtual void draw(double offsetX, double offsetZ, double scale,
                     QPainter *canvas) const;
   virtual Point midpoint() const;
+  virtual Cuboid bounds() const;
   void setExtraColor(const QColor& c) {extraColor = c;}
 
   static const int RADIUS = 5;
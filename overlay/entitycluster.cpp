@@ -0,0 +1,71 @@
+#include <QPainter>
+#include <algorithm>
+
+#include "overlay/entitycluster.h"
+
+EntityCluster::EntityCluster()
+  : count(0)
+  , colorCount(0)
+  , sumX(0)
+  , sumZ(0)
+  , lowest(0)
+{}
+
+void EntityCluster::add(const OverlayItem &item) {
+  const OverlayItem::Point p = item.midpoint();
+  if (count == 0) {
+    color  = item.color();
+    lowest = p.y;
+  }
+  lowest = std::min(lowest, p.y);
+  count++;
+  colorCount++;
+  sumX += p.x;
+  sumZ += p.z;
+}
+
+void EntityCluster::add(const EntityCluster &other) {
+  if (other.count == 0)
+    return;
+  lowest = (count == 0) ? other.lowest : std::min(lowest, other.lowest);
+  if (other.count > colorCount) {
+    color      = other.color;
+    colorCount = other.count;
+  }
+  count += other.count;
+  sumX  += other.sumX;
+  sumZ  += other.sumZ;
+}
+
+OverlayItem::Point EntityCluster::getCenter() const {
+  if (count == 0)
+    return OverlayItem::Point();
+  return OverlayItem::Point(sumX / count, lowest, sumZ / count);
+}
+
+void EntityCluster::draw(double offsetX, double offsetZ, double scale,
+                         QPainter *canvas) const {
+  const OverlayItem::Point p = getCenter();
+  const QPointF center((p.x - offsetX) * scale,
+                       (p.z - offsetZ) * scale);
+
+  QColor brushColor = color;
+  brushColor.setAlpha(192);
+  QPen pen = canvas->pen();
+  pen.setColor(QColor(0, 0, 0, 160));
+  pen.setWidth(1);
+  canvas->setPen(pen);
+  canvas->setBrush(brushColor);
+  canvas->drawEllipse(center, RADIUS, RADIUS);
+
+  // count as label, shortened to fit into the marker
+  const QString label = (count < 1000) ? QString::number(count)
+                                       : QString("%1k").arg(std::min(count / 1000, 99));
+  QFont font = canvas->font();
+  font.setPixelSize(RADIUS);
+  font.setBold(true);
+  canvas->setFont(font);
+  canvas->setPen((brushColor.lightness() > 140) ? Qt::black : Qt::white);
+  canvas->drawText(QRectF(center.x() - RADIUS, center.y() - RADIUS, 2 * RADIUS, 2 * RADIUS),
+                   Qt::AlignCenter, label);
+}
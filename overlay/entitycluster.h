@@ -0,0 +1,40 @@
+#ifndef ENTITYCLUSTER_H_
+#define ENTITYCLUSTER_H_
+
+#include <QColor>
+#include <QHash>
+#include <QString>
+#include "overlay/overlayitem.h"
+
+class QPainter;
+
+// Aggregate of many Entities, drawn as one marker labeled with their count
+// where single Entities can't be told apart anymore.
+class EntityCluster {
+ public:
+  EntityCluster();
+
+  void add(const OverlayItem &item);  // Entities of one type only
+  // the color of the larger part is kept, so merge Entities of one type first
+  void add(const EntityCluster &other);
+
+  int    getCount() const  { return count; }
+  double getLowest() const { return lowest; }
+  OverlayItem::Point getCenter() const;  // mean position
+
+  void draw(double offsetX, double offsetZ, double scale, QPainter *canvas) const;
+
+  static const int RADIUS = 9;
+
+ private:
+  int    count;
+  int    colorCount;  // Entities of the kind giving the color
+  double sumX, sumZ;
+  double lowest;
+  QColor color;
+};
+
+// Entities of one Chunk aggregated per type, made when it is rendered
+typedef QHash<QString, EntityCluster> EntitySummary;
+
+#endif  // ENTITYCLUSTER_H_
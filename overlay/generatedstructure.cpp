@@ -266,3 +266,7 @@ void GeneratedStructure::draw(double offsetX, double offsetZ, double scale,
 GeneratedStructure::Point GeneratedStructure::midpoint() const {
   return Point((p1.x + p2.x) / 2, (p1.y + p2.y) / 2, (p1.z + p2.z) / 2);
 }
+
+GeneratedStructure::Cuboid GeneratedStructure::bounds() const {
+  return Cuboid(p1, p2);
+}
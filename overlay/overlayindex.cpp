@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cmath>
+
+#include "overlay/overlayindex.h"
+
+OverlayIndex::OverlayIndex()
+  : count(0)
+{}
+
+int OverlayIndex::getCell(double coordinate) {
+  return static_cast<int>(floor(coordinate)) >> CELL_BITS;
+}
+
+bool OverlayIndex::insert(const QSharedPointer<OverlayItem> &item) {
+  const OverlayItem::Point p = item->midpoint();
+  const Position position = { item->type(), item->dimension(), p.x, p.y, p.z };
+  if (positions.contains(position))
+    return false;
+  positions.insert(position);
+  count++;
+
+  const OverlayItem::Cuboid box = item->bounds();
+  const int x0 = getCell(box.min.x), x1 = getCell(box.max.x);
+  const int z0 = getCell(box.min.z), z1 = getCell(box.max.z);
+  if ((x1 - x0 + 1) * (z1 - z0 + 1) > MAX_CELLS) {
+    large.append(item);
+    return true;
+  }
+  const Entry entry = { item, x0, z0 };
+  for (int cz = z0; cz <= z1; cz++)
+    for (int cx = x0; cx <= x1; cx++)
+      cells[ChunkID(cx, cz)].append(entry);
+  return true;
+}
+
+void OverlayIndex::clear() {
+  cells.clear();
+  large.clear();
+  positions.clear();
+  count = 0;
+}
+
+QList<QSharedPointer<OverlayItem>> OverlayIndex::query(const OverlayItem::Cuboid &cuboid) const {
+  QList<QSharedPointer<OverlayItem>> result;
+  if (count == 0)
+    return result;
+
+  const int x0 = getCell(cuboid.min.x), x1 = getCell(cuboid.max.x);
+  const int z0 = getCell(cuboid.min.z), z1 = getCell(cuboid.max.z);
+  auto collect = [&](int cx, int cz, const QVector<Entry> &cell) {
+    for (const Entry &entry : cell) {
+      // items in several cells are reported from the first cell inside the query only
+      if ((cx != std::max(entry.cx, x0)) || (cz != std::max(entry.cz, z0)))
+        continue;
+      if (entry.item->intersects(cuboid))
+        result.append(entry.item);
+    }
+  };
+
+  if (qint64(x1 - x0 + 1) * (z1 - z0 + 1) > cells.size()) {
+    // far zoomed out, fewer cells in use than covered
+    for (auto cell = cells.constBegin(); cell != cells.constEnd(); ++cell) {
+      const int cx = cell.key().getX();
+      const int cz = cell.key().getZ();
+      if ((cx >= x0) && (cx <= x1) && (cz >= z0) && (cz <= z1))
+        collect(cx, cz, *cell);
+    }
+  } else {
+    for (int cz = z0; cz <= z1; cz++) {
+      for (int cx = x0; cx <= x1; cx++) {
+        auto cell = cells.constFind(ChunkID(cx, cz));
+        if (cell != cells.constEnd())
+          collect(cx, cz, *cell);
+      }
+    }
+  }
+  for (const auto &item : large)
+    if (item->intersects(cuboid))
+      result.append(item);
+  return result;
+}
@@ -0,0 +1,61 @@
+#ifndef OVERLAYINDEX_H_
+#define OVERLAYINDEX_H_
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QSharedPointer>
+#include <QVector>
+#include "chunkid.h"
+#include "overlay/overlayitem.h"
+
+// Uniform grid over the X/Z plane to find overlay items inside a view or at
+// a position without scanning all of them. Items are kept in every cell they
+// cover, items covering a lot of cells are kept in a plain list instead.
+// Items of the same type at the same position in the same dimension are only
+// kept once.
+class OverlayIndex {
+ public:
+  OverlayIndex();
+
+  // returns false when a like item at the same position is already present
+  bool insert(const QSharedPointer<OverlayItem> &item);
+  void clear();
+  int  size() const { return count; }
+
+  // all items intersecting cuboid, each one only once
+  QList<QSharedPointer<OverlayItem>> query(const OverlayItem::Cuboid &cuboid) const;
+
+ private:
+  static const int CELL_BITS = 8;   // 256x256 Blocks per cell
+  static const int MAX_CELLS = 16;  // items covering more cells are not gridded
+
+  struct Entry {
+    QSharedPointer<OverlayItem> item;
+    int cx, cz;  // first cell covered by the item
+  };
+
+  struct Position {
+    QString type;
+    QString dimension;
+    double  x, y, z;
+
+    bool operator==(const Position &other) const {
+      return (x == other.x) && (y == other.y) && (z == other.z) &&
+             (dimension == other.dimension) && (type == other.type);
+    }
+    friend uint qHash(const Position &p) {
+      return qHash(p.type) ^ qHash(p.dimension) ^
+             qHash(p.x) ^ (qHash(p.y) << 1) ^ (qHash(p.z) << 2);
+    }
+  };
+
+  static int getCell(double coordinate);
+
+  QHash<ChunkID, QVector<Entry>> cells;  // key uses cell coordinates
+  QVector<QSharedPointer<OverlayItem>> large;
+  QSet<Position> positions;
+  int count;
+};
+
+#endif  // OVERLAYINDEX_H_
@@ -31,6 +31,7 @@ class OverlayItem {
   virtual void draw(double offsetX, double offsetZ, double scale,
                     QPainter *canvas) const = 0;
   virtual Point midpoint() const = 0;
+  virtual Cuboid bounds() const = 0;  // axis aligned box enclosing the item
   const QString& type() const {return itemType;}
   const QString& display() const { return itemDescription;}
   const QVariant& properties() const { return itemProperties;}
@@ -9,6 +9,7 @@
 class PaletteEntry {
  public:
   uint    hid;   // we use hashed name as ID
+  quint16 cid;   // compact ID into BlockIdentifier render table
   QString name;
   QMap<QString, QVariant> properties;
 
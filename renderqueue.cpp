@@ -0,0 +1,100 @@
+#include <QSettings>
+#include <QThread>
+#include <algorithm>
+#include <climits>
+
+#include "renderqueue.h"
+#include "chunkrenderer.h"
+
+RenderQueue::RenderQueue() {
+  setThreadCount(QSettings().value("renderthreads", 0).toInt());
+
+  qRegisterMetaType<QVector<QPoint>>("QVector<QPoint>");
+}
+
+RenderQueue::~RenderQueue() {
+  cancelAll();
+  pool.waitForDone();
+}
+
+RenderQueue &RenderQueue::Instance() {
+  static RenderQueue singleton;
+  return singleton;
+}
+
+void RenderQueue::setThreadCount(int threads) {
+  if (threads <= 0)
+    threads = QThread::idealThreadCount();
+  pool.setMaxThreadCount(std::max(threads, 1));
+}
+
+int RenderQueue::getThreadCount() const {
+  return pool.maxThreadCount();
+}
+
+void RenderQueue::render(const ChunkID &batch, ChunkRenderer *renderer, Priority priority) {
+  QMutexLocker guard(&mutex);
+  auto it = queued.find(batch);
+  if ((it != queued.end()) && pool.tryTake(it->renderer)) {
+    // still waiting, render all Chunks in one go
+    renderer->merge(*it->renderer);
+    priority = std::max(priority, it->priority);
+    delete it->renderer;
+  }
+  queued.insert(batch, { renderer, priority });
+  pool.start(renderer, priority);
+}
+
+void RenderQueue::promote(int cx, int cz, Priority priority) {
+  QMutexLocker guard(&mutex);
+  auto it = queued.find(getBatch(cx, cz));
+  if ((it == queued.end()) || (it->priority >= priority))
+    return;
+  // requeue with new priority, unless it is already running
+  if (pool.tryTake(it->renderer)) {
+    it->priority = priority;
+    pool.start(it->renderer, priority);
+  }
+}
+
+void RenderQueue::cancelOutside(const QRect &area) {
+  cancelStale(area, INT_MIN, 0);  // any depth
+}
+
+void RenderQueue::cancelStale(const QRect &area, int depth, int flags) {
+  const int scanFlags = GBuffer::getScanFlags(flags);
+  QMutexLocker guard(&mutex);
+  for (auto it = queued.begin(); it != queued.end(); ) {
+    const QRect chunks(it.key().getX() * BATCH_SIZE, it.key().getZ() * BATCH_SIZE,
+                       BATCH_SIZE, BATCH_SIZE);
+    // a G-buffer of the same scan can still be shaded with the new flags
+    const bool stale = (depth != INT_MIN) &&
+                       ((it->renderer->getDepth() != depth) ||
+                        (GBuffer::getScanFlags(it->renderer->getFlags()) != scanFlags));
+    if (area.intersects(chunks) && !stale) {
+      ++it;
+      continue;
+    }
+    // already running renders can't be taken back
+    if (pool.tryTake(it->renderer)) {
+      it->renderer->cancel();
+      delete it->renderer;
+    }
+    it = queued.erase(it);
+  }
+}
+
+void RenderQueue::cancelAll() {
+  cancelOutside(QRect());  // empty area contains no Chunk
+}
+
+void RenderQueue::waitForDone() {
+  pool.waitForDone();
+}
+
+void RenderQueue::started(const ChunkID &batch, ChunkRenderer *renderer) {
+  QMutexLocker guard(&mutex);
+  auto it = queued.find(batch);
+  if ((it != queued.end()) && (it->renderer == renderer))
+    queued.erase(it);
+}
@@ -0,0 +1,69 @@
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include <QHash>
+#include <QMutex>
+#include <QRect>
+#include <QThreadPool>
+#include "chunkid.h"
+
+class ChunkRenderer;
+
+// Thread pool of its own for rendering Chunks, so
+// rendering neither starves nor gets starved by other users of the global
+// QThreadPool (e.g. search). Chunks are rendered in batches of neighboring
+// Chunks, queued batches are ordered by priority and are cancelled once
+// their Chunks are no longer of interest.
+class RenderQueue {
+ public:
+  static const int BATCH_BITS = 3;  // a batch covers up to 8x8 Chunks
+  static const int BATCH_SIZE = 1 << BATCH_BITS;
+
+  enum Priority {
+    prioPrefetch = 1,  // ring around the view, probably visible soon
+    prioVisible  = 2   // Chunks on screen
+  };
+
+  // singleton: access to global usable instance
+  static RenderQueue &Instance();
+
+  void setThreadCount(int threads);  // 0 selects one thread per core
+  int  getThreadCount() const;
+
+  // batch a Chunk belongs to
+  static ChunkID getBatch(int cx, int cz) { return ChunkID(cx >> BATCH_BITS, cz >> BATCH_BITS); }
+
+  // queue rendering of a batch, takes ownership of the renderer,
+  // it is merged with a batch still waiting in the queue
+  void render(const ChunkID &batch, ChunkRenderer *renderer, Priority priority);
+  // raise priority of an already queued render of a Chunk
+  void promote(int cx, int cz, Priority priority);
+
+  // drop queued batches without any Chunk inside of area (Chunk coordinates)
+  void cancelOutside(const QRect &area);
+  // same, and also batches of another depth or flags changing the scan
+  void cancelStale(const QRect &area, int depth, int flags);
+  void cancelAll();
+  void waitForDone();
+
+  // called by a renderer when it starts running, it can't be cancelled anymore
+  void started(const ChunkID &batch, ChunkRenderer *renderer);
+
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  RenderQueue();
+  ~RenderQueue();
+  RenderQueue(const RenderQueue &);
+  RenderQueue &operator=(const RenderQueue &);
+
+  struct Queued {
+    ChunkRenderer *renderer;
+    Priority       priority;
+  };
+
+  QThreadPool pool;
+  QMutex      mutex;             // protects queued
+  QHash<ChunkID, Queued> queued;  // batches not yet running
+};
+
+#endif  // RENDERQUEUE_H_
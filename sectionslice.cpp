@@ -0,0 +1,31 @@
+#include <QVarLengthArray>
+#include <algorithm>
+
+#include "sectionslice.h"
+
+SectionSlice::SectionSlice(const ChunkSection &section, Axis axis, int pos) {
+  const RenderBlockInfo *renderTable = BlockIdentifier::Instance().getRenderTable();
+
+  // resolve the palette once, the shared legacy palette is too large for that
+  const int length = section.blockPaletteIsShared ? 0 : section.blockPaletteLength;
+  QVarLengthArray<const RenderBlockInfo *, 256> palette(length);
+  for (int i = 0; i < length; i++)
+    palette[i] = &renderTable[section.blockPalette[i].cid];
+
+  // Block index inside Section is x + 16*z + 256*y
+  int origin, stepU, stepV;
+  switch (axis) {
+    case axisX:          origin = pos + 256 * 15;      stepU = 16; stepV = -256; break;
+    case axisY:          origin = 256 * pos;           stepU = 1;  stepV = 16;   break;
+    case axisZ: default: origin = 16 * pos + 256 * 15; stepU = 1;  stepV = -256; break;
+  }
+
+  for (int v = 0; v < 16; v++) {
+    int index = origin + v * stepV;
+    for (int u = 0; u < 16; u++, index += stepU) {
+      quint16 blockid = section.blocks[index];
+      info[u + 16 * v] = (blockid < length) ? palette[blockid]
+                                            : &renderTable[section.getCompactId(index)];
+    }
+  }
+}
@@ -0,0 +1,28 @@
+#ifndef SECTIONSLICE_H_
+#define SECTIONSLICE_H_
+
+#include "chunk.h"
+#include "identifier/blockidentifier.h"
+
+// Render info of one axis aligned 16x16 plane of Blocks inside a Section.
+// The palette of the Section is resolved once, afterwards the Block indices
+// of the plane map straight through it into the render table.
+class SectionSlice {
+ public:
+  enum Axis {
+    axisX,  // Z-Y plane at fixed x, index is z + 16*row
+    axisY,  // X-Z plane at fixed y, index is x + 16*z
+    axisZ   // X-Y plane at fixed z, index is x + 16*row
+  };
+
+  // pos is the local coordinate (0..15) along axis,
+  // rows of vertical planes are ordered top->down
+  SectionSlice(const ChunkSection &section, Axis axis, int pos);
+
+  const RenderBlockInfo &operator[](int index) const { return *info[index]; }
+
+ private:
+  const RenderBlockInfo *info[16 * 16];
+};
+
+#endif  // SECTIONSLICE_H_
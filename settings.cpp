@@ -27,6 +27,28 @@ Settings::Settings(QWidget *parent) : QDialog(parent) {
   connect(m_ui.checkBox_VerticalDepth, SIGNAL(toggled(bool)),
           this, SLOT(toggleVerticalDepth(bool)));
 
+  connect(m_ui.checkBox_DiskTileCache, SIGNAL(toggled(bool)),
+          this, SLOT(toggleDiskTileCache(bool)));
+  connect(m_ui.checkBox_DiskTileCache, SIGNAL(toggled(bool)),
+          m_ui.spinBox_DiskTileCacheSize, SLOT(setEnabled(bool)));
+
+  connect(m_ui.spinBox_DiskTileCacheSize, SIGNAL(valueChanged(int)),
+          this, SLOT(changeDiskTileCacheSize(int)));
+
+  connect(m_ui.checkBox_SpillChunks, SIGNAL(toggled(bool)),
+          this, SLOT(toggleSpillChunks(bool)));
+  connect(m_ui.checkBox_SpillChunks, SIGNAL(toggled(bool)),
+          m_ui.spinBox_SpillSize, SLOT(setEnabled(bool)));
+
+  connect(m_ui.spinBox_SpillSize, SIGNAL(valueChanged(int)),
+          this, SLOT(changeSpillSize(int)));
+
+  connect(m_ui.spinBox_RenderThreads, SIGNAL(valueChanged(int)),
+          this, SLOT(changeRenderThreads(int)));
+
+  connect(m_ui.spinBox_PrefetchBudget, SIGNAL(valueChanged(int)),
+          this, SLOT(changePrefetchBudget(int)));
+
   connect(m_ui.checkBox_AutoUpdate, SIGNAL(toggled(bool)),
           this, SLOT(toggleAutoUpdate(bool)));
 
@@ -58,6 +80,12 @@ Settings::Settings(QWidget *parent) : QDialog(parent) {
   }
   autoUpdate    = info.value("autoupdate", true).toBool();
   verticalDepth = info.value("verticaldepth", true).toBool();
+  diskTileCache = info.value("disktilecache", true).toBool();
+  diskTileCacheSize = info.value("disktilecachesize", 1024).toInt();
+  spillChunks   = info.value("spillchunks", false).toBool();
+  spillSize     = info.value("spillsize", 4096).toInt();
+  renderThreads = info.value("renderthreads", 0).toInt();
+  prefetchBudget = info.value("prefetchbudget", 256).toInt();
   modifier4DepthSlider = Qt::KeyboardModifier(info.value("modifier4DepthSlider", 0x02000000).toUInt());
   modifier4ZoomOut     = Qt::KeyboardModifier(info.value("modifier4ZoomOut",     0x04000000).toUInt());
 
@@ -66,6 +94,14 @@ Settings::Settings(QWidget *parent) : QDialog(parent) {
   m_ui.lineEdit_Location->setDisabled(useDefault);
   m_ui.checkBox_DefaultLocation->setChecked(useDefault);
   m_ui.checkBox_VerticalDepth->setChecked(verticalDepth);
+  m_ui.checkBox_DiskTileCache->setChecked(diskTileCache);
+  m_ui.spinBox_DiskTileCacheSize->setValue(diskTileCacheSize);
+  m_ui.spinBox_DiskTileCacheSize->setEnabled(diskTileCache);
+  m_ui.checkBox_SpillChunks->setChecked(spillChunks);
+  m_ui.spinBox_SpillSize->setValue(spillSize);
+  m_ui.spinBox_SpillSize->setEnabled(spillChunks);
+  m_ui.spinBox_RenderThreads->setValue(renderThreads);
+  m_ui.spinBox_PrefetchBudget->setValue(prefetchBudget);
   m_ui.checkBox_AutoUpdate->setChecked(autoUpdate);
   switch (modifier4DepthSlider) {
   case Qt::ControlModifier:
@@ -153,6 +189,48 @@ void Settings::toggleVerticalDepth(bool value) {
   emit settingsUpdated();
 }
 
+void Settings::toggleDiskTileCache(bool value) {
+  diskTileCache = value;
+  QSettings info;
+  info.setValue("disktilecache", value);
+  emit cacheSettingsChanged();
+}
+
+void Settings::changeDiskTileCacheSize(int value) {
+  diskTileCacheSize = value;
+  QSettings info;
+  info.setValue("disktilecachesize", value);
+  emit cacheSettingsChanged();
+}
+
+void Settings::toggleSpillChunks(bool value) {
+  spillChunks = value;
+  QSettings info;
+  info.setValue("spillchunks", value);
+  emit cacheSettingsChanged();
+}
+
+void Settings::changeSpillSize(int value) {
+  spillSize = value;
+  QSettings info;
+  info.setValue("spillsize", value);
+  emit cacheSettingsChanged();
+}
+
+void Settings::changeRenderThreads(int value) {
+  renderThreads = value;
+  QSettings info;
+  info.setValue("renderthreads", value);
+  emit cacheSettingsChanged();
+}
+
+void Settings::changePrefetchBudget(int value) {
+  prefetchBudget = value;
+  QSettings info;
+  info.setValue("prefetchbudget", value);
+  emit cacheSettingsChanged();
+}
+
 void Settings::toggleModifier4DepthSlider() {
   if (m_ui.radioButton_depth_shift->isChecked()) {
     modifier4DepthSlider = Qt::ShiftModifier;
@@ -14,6 +14,12 @@ class Settings : public QDialog {
   QString mcpath;
   bool verticalDepth;
   bool autoUpdate;
+  bool diskTileCache;
+  int  diskTileCacheSize;
+  bool spillChunks;
+  int  spillSize;
+  int  renderThreads;  // 0 for one per core
+  int  prefetchBudget;  // outstanding Chunk prefetches, 0 disables prefetching
   Qt::KeyboardModifier modifier4DepthSlider;
   Qt::KeyboardModifier modifier4ZoomOut;
 
@@ -22,6 +28,7 @@ class Settings : public QDialog {
 
  signals:
   void settingsUpdated();
+  void cacheSettingsChanged();  // does not affect the world list
   void locationChanged(const QString &loc);
   void checkForUpdates();
 
@@ -32,6 +39,12 @@ class Settings : public QDialog {
   void toggleDefaultLocation(bool on);
   void pathChanged(const QString &path);
   void toggleVerticalDepth(bool on);
+  void toggleDiskTileCache(bool on);
+  void changeDiskTileCacheSize(int mb);
+  void toggleSpillChunks(bool on);
+  void changeSpillSize(int mb);
+  void changeRenderThreads(int threads);
+  void changePrefetchBudget(int chunks);
   void toggleModifier4DepthSlider();
   void toggleModifier4ZoomOut();
 
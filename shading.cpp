@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cmath>
+
+#include "shading.h"
+#include "clamp.h"
+
+// static members are bound to references by std::fill_n() and friends
+const int CaveShade::CAVE_DEPTH;
+const int CaveShade::ONE;
+
+
+// define a shading curve for Cave Mode:
+
+CaveShade::CaveShade()
+{
+  // calculate exponential function for cave shade
+  float caveshadeF[CAVE_DEPTH];
+  float cavesum = 0.0;
+  for (int i=0; i<CAVE_DEPTH; i++) {
+    caveshadeF[i] = 1/exp(i/(CAVE_DEPTH/2.0));
+    cavesum += caveshadeF[i];
+  }
+  // store as 16.16 fixed point
+  for (int i=0; i<CAVE_DEPTH; i++) {
+    caveshade[i] = qRound(ONE * 1.5 * caveshadeF[i] / cavesum);
+  }
+  // sum of shades for each byte of a probe window, bit 15 is index 0
+  for (int bits=0; bits<256; bits++) {
+    lowSum[bits] = highSum[bits] = 0;
+    for (int b=0; b<8; b++) {
+      if (bits & (1 << b)) {
+        lowSum[bits]  += caveshade[15 - b];
+        highSum[bits] += caveshade[7 - b];
+      }
+    }
+  }
+}
+
+int CaveShade::getShade(int index) {
+  return Instance().caveshade[index];
+}
+
+int CaveShade::getShadeSum(quint16 window) {
+  const CaveShade &singleton = Instance();
+  return singleton.lowSum[window & 0xff] + singleton.highSum[window >> 8];
+}
+
+const CaveShade &CaveShade::Instance() {
+  static CaveShade singleton;
+  return singleton;
+}
+
+
+// define light attenuation similar to Minecraft
+// except base 90% here, were Minecraft is using 80% per level
+
+LightShade::LightShade()
+{
+  for (int i=0; i<LIGHT_LEVELS; i++) {
+    lightfactor[i] = qRound(65536 * pow(0.90, 15 - (i + LIGHT_MIN)));
+  }
+}
+
+quint32 LightShade::getFactor(int light) {
+  static LightShade singleton;
+  return singleton.lightfactor[std::clamp(light - LIGHT_MIN, 0, LIGHT_LEVELS - 1)];
+}
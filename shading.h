@@ -0,0 +1,48 @@
+#ifndef SHADING_H_
+#define SHADING_H_
+
+#include <QtGlobal>
+
+// fixed point tables used when shading a GBuffer
+
+class CaveShade {
+ public:
+  // singleton: access to global usable instance
+  static int getShade(int index);  // 16.16 fixed point
+  // sum of shades for all transparent Blocks in a probe window of CAVE_DEPTH
+  // Blocks, bit 15 is the Block directly below the surface
+  static int getShadeSum(quint16 window);
+ private:
+  static const CaveShade &Instance();
+  // singleton: prevent access to constructor and copyconstructor
+  CaveShade();
+  ~CaveShade() {}
+  CaveShade(const CaveShade &);
+  CaveShade &operator=(const CaveShade &);
+
+ public:
+  static const int CAVE_DEPTH = 16;  // maximum depth caves are searched in cave mode
+  static const int ONE = 1 << 16;    // fixed point 1.0
+  int caveshade[CAVE_DEPTH];
+  int lowSum[256];   // bits 0..7 of probe window
+  int highSum[256];  // bits 8..15 of probe window
+};
+
+class LightShade {
+ public:
+  // singleton: access to global usable instance
+  static quint32 getFactor(int light);  // 16.16 fixed point
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  LightShade();
+  ~LightShade() {}
+  LightShade(const LightShade &);
+  LightShade &operator=(const LightShade &);
+
+ public:
+  static const int LIGHT_MIN    = -2;  // edge highlight can leave the 0..15 range
+  static const int LIGHT_LEVELS = 20;  // -2 .. 17
+  quint32 lightfactor[LIGHT_LEVELS];
+};
+
+#endif  // SHADING_H_
@@ -0,0 +1,116 @@
+#include "spawnmask.h"
+#include "identifier/blockidentifier.h"
+#include "identifier/biomeidentifier.h"
+
+SpawnMask::SpawnMask()
+  : generation(BlockIdentifier::Instance().getGeneration())
+{}
+
+SpawnMask::~SpawnMask() {
+  qDeleteAll(sections);
+}
+
+bool SpawnMask::isValid() const {
+  return generation == BlockIdentifier::Instance().getGeneration();
+}
+
+const SpawnMask::Bits *SpawnMask::getSection(const Chunk &chunk, int sec) {
+  QMutexLocker locker(&mutex);
+  Bits *&bits = sections[sec];
+  if (!bits) {
+    bits = new Bits;
+    build(chunk, sec, *bits);
+  }
+  return bits;
+}
+
+void SpawnMask::fillPlanes(const ChunkSection *section, int from, int to, int layer,
+                           int lightSpawnSave, Planes &planes) const {
+  const RenderBlockInfo *renderTable = BlockIdentifier::Instance().getRenderTable();
+
+  for (int y = from; y < to; y++, layer++) {
+    for (int word = 0; word < 4; word++) {
+      quint64 top = 0, air = 0, dry = 0, water = 0, dark = 0;
+      for (int b = 0; b < 64; b++) {
+        const int     index = (y << 8) + (word << 6) + b;
+        const quint64 bit   = Q_UINT64_C(1) << b;
+        // missing Section is legacy air without light
+        quint16 cid = 0;
+        int   light = 0;
+        if (section) {
+          cid   = section->getCompactId(index);
+          light = (section->blockLight[index >> 1] >> ((index & 1) << 2)) & 0x0f;
+        }
+        const RenderBlockInfo &block = renderTable[cid];
+        if (block.is(RenderBlockInfo::flgSpawnOnTop))
+          top |= bit;
+        if (!block.is(RenderBlockInfo::flgNormalCube) && block.is(RenderBlockInfo::flgSpawnInside)) {
+          air |= bit;
+          if (!block.is(RenderBlockInfo::flgLiquid))
+            dry |= bit;
+        }
+        if (block.is(RenderBlockInfo::flgBiomeWater))
+          water |= bit;
+        if (light < lightSpawnSave)
+          dark |= bit;
+      }
+      const int idx = (layer << 2) + word;
+      planes.top[idx]   = top;
+      planes.air[idx]   = air;
+      planes.dry[idx]   = dry;
+      planes.water[idx] = water;
+      planes.dark[idx]  = dark;
+    }
+  }
+}
+
+void SpawnMask::build(const Chunk &chunk, int sec, Bits &bits) const {
+  // threshold for mob spawn detection
+  const int lightSpawnSave = (chunk.getVersion() >= 2800)? 1 : 8;
+  const ChunkSection *section = chunk.getSectionByIdx(sec);
+
+  // layer 0 is the top layer of the Section below, layers 17 and 18 are above
+  Planes planes;
+  fillPlanes(chunk.getSectionByIdx(sec - 1), 15, 16,  0, lightSpawnSave, planes);
+  fillPlanes(section,                         0, 16,  1, lightSpawnSave, planes);
+  fillPlanes(chunk.getSectionByIdx(sec + 1),  0,  2, 17, lightSpawnSave, planes);
+
+  const BiomeIdentifier &biomes = BiomeIdentifier::Instance();
+  for (int word = 0; word < 64; word++) {
+    const int at    = word + 4;  // same Blocks in planes
+    const int above = at + 4;
+    const int below = at - 4;
+
+    // spawn check #1: on top of solid block
+    bits.onTop[word] = planes.top[at] &
+                       planes.dark[above] & planes.dry[above] &
+                       planes.air[above + 4];
+    // spawn check #2: current block is transparent,
+    // but mob can spawn through from block below (e.g. snow)
+    bits.through[word] = planes.top[below] &
+                         planes.dark[at] & planes.dry[at] &
+                         planes.air[above];
+    // water spawn check for Drowned, introduced with "Update Aquatic" (1.13)
+    bits.drowned[word] = 0;
+    if (chunk.getVersion() < 1478)
+      continue;
+    quint64 candidates = planes.water[at] & planes.water[above] & planes.dark[at];
+    for (; candidates; candidates &= candidates - 1) {
+      const int index  = (word << 6) + qCountTrailingZeroBits(candidates);
+      const int offset = index & 0xff;
+      const int y      = (sec << 4) + (index >> 8);
+      qint32 biomeID;
+      if (chunk.getVersion() >= 2800) {
+        // Minecraft 1.18 has Y dependand Biome stored per Section
+        biomeID = section->biomes[((offset & 0x0f) >> 2) + ((offset >> 6) << 2) + (((y & 0x0f) >> 2) << 4)];
+      } else {
+        biomeID = chunk.getBiomeID(offset & 0x0f, y, offset >> 4);
+      }
+      const BiomeInfo &biome = (chunk.getVersion() >= 2800) ?
+          biomes.getBiome(static_cast<quint8>(biomeID)) :
+          biomes.getBiome(static_cast<qint32>(biomeID));
+      if ((biome.isOceanBiome() && (y < 58)) || biome.isRiverBiome())
+        bits.drowned[word] |= Q_UINT64_C(1) << (index & 63);
+    }
+  }
+}
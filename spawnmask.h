@@ -0,0 +1,57 @@
+#ifndef SPAWNMASK_H_
+#define SPAWNMASK_H_
+
+#include <QHash>
+#include <QMutex>
+#include "chunk.h"
+#include "gbuffer.h"
+
+// Mob spawn detection of all Blocks in a Chunk as one bit per Block and rule.
+// Each Section is evaluated once on first use with bitwise operations on
+// property planes of its Blocks, the render kernels only test a bit.
+class SpawnMask {
+ public:
+  struct Bits {
+    quint64 onTop[64];    // on top of solid Block
+    quint64 through[64];  // through transparent Block from Block below
+    quint64 drowned[64];  // water spawn
+
+    // GBuffer spawn bits, index is x + 16*z + 256*(y & 0x0f)
+    quint8 get(int index) const;
+  };
+
+  SpawnMask();
+  ~SpawnMask();
+
+  // evaluated on first call for each Section
+  const Bits *getSection(const Chunk &chunk, int sec);
+  bool isValid() const;  // Block definitions did not change since build
+
+ private:
+  // Block properties of layers -1 .. 17 around one Section, 4 words per layer
+  struct Planes {
+    static const int WORDS = 19 * 4;
+    quint64 top[WORDS];    // solid top surface
+    quint64 air[WORDS];    // mob fits inside
+    quint64 dry[WORDS];    // mob fits inside, not liquid
+    quint64 water[WORDS];  // Biome water
+    quint64 dark[WORDS];   // Block light below spawn threshold
+  };
+  void fillPlanes(const ChunkSection *section, int from, int to, int layer,
+                  int lightSpawnSave, Planes &planes) const;
+  void build(const Chunk &chunk, int sec, Bits &bits) const;
+
+  QHash<int, Bits*> sections;
+  QMutex            mutex;
+  int               generation;
+};
+
+inline quint8 SpawnMask::Bits::get(int index) const {
+  const int     word = index >> 6;
+  const quint64 bit  = Q_UINT64_C(1) << (index & 63);
+  return ((onTop[word]   & bit) ? GBuffer::spawnOnTop   : 0) |
+         ((through[word] & bit) ? GBuffer::spawnThrough : 0) |
+         ((drowned[word] & bit) ? GBuffer::spawnDrowned : 0);
+}
+
+#endif  // SPAWNMASK_H_
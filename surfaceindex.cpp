@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <vector>
+
+#include "surfaceindex.h"
+#include "identifier/blockidentifier.h"
+
+SurfaceIndex::SurfaceIndex(const Chunk &chunk)
+  : generation(BlockIdentifier::Instance().getGeneration())
+{
+  const RenderBlockInfo *renderTable = BlockIdentifier::Instance().getRenderTable();
+
+  // run length encode visibility of each column, top->down
+  std::vector<Interval> columns[16 * 16];
+  int last[16 * 16];
+  std::fill_n(last, 16 * 16, -1);
+
+  auto append = [&](int offset, int y, int cls) {
+    if (last[offset] != cls) {
+      columns[offset].push_back({ static_cast<short>(y), static_cast<short>(cls) });
+      last[offset] = cls;
+    }
+  };
+
+  int y = chunk.getHighest();
+  while (y >= chunk.getLowest()) {
+    const int sec = y >> 4;
+    const int bottom = std::max(chunk.getLowest(), sec << 4);
+    const ChunkSection *section = chunk.getSectionByIdx(sec);
+    if (!section) {
+      // missing Section is air
+      for (int offset = 0; offset < 16 * 16; offset++)
+        append(offset, y, clsAir);
+      y = bottom - 1;
+      continue;
+    }
+    for (; y >= bottom; y--) {
+      const int slice = (y & 0x0f) << 8;
+      for (int offset = 0; offset < 16 * 16; offset++) {
+        const RenderBlockInfo &block = renderTable[section->getCompactId(slice + offset)];
+        if (qAlpha(block.color) == 0)
+          append(offset, y, clsAir);
+        else if (block.is(RenderBlockInfo::flgLiquid))
+          append(offset, y, clsLiquid);
+        else
+          append(offset, y, clsVisible);
+      }
+    }
+  }
+
+  // pack all columns, terminated by air below the lowest Block
+  int total = 0;
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    first[offset] = total;
+    total += columns[offset].size() + 1;
+  }
+  first[16 * 16] = total;
+  intervals.reserve(total);
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    for (const Interval &interval : columns[offset])
+      intervals.append(interval);
+    intervals.append({ static_cast<short>(chunk.getLowest() - 1), static_cast<short>(clsAir) });
+  }
+}
+
+int SurfaceIndex::findVisible(int offset, int y, bool skipLiquid) const {
+  const Interval *begin = intervals.constData() + first[offset];
+  const Interval *end   = intervals.constData() + first[offset + 1];
+
+  // intervals are sorted top->down, find the one containing y
+  const Interval *it = std::upper_bound(begin, end, y,
+                                        [](int y, const Interval &i) { return y > i.top; });
+  if (it != begin)
+    --it;  // above the first interval is only air
+
+  // skip invisible intervals
+  for (; it != end; ++it) {
+    if ((it->cls == clsVisible) || ((it->cls == clsLiquid) && !skipLiquid))
+      return std::min<int>(y, it->top);
+  }
+  return -4096;
+}
+
+bool SurfaceIndex::isValid() const {
+  return generation == BlockIdentifier::Instance().getGeneration();
+}
+
+int SurfaceIndex::size() const {
+  return sizeof(SurfaceIndex) + intervals.size() * sizeof(Interval);
+}
@@ -0,0 +1,33 @@
+#ifndef SURFACEINDEX_H_
+#define SURFACEINDEX_H_
+
+#include <QVector>
+#include "chunk.h"
+
+// Per column list of y-intervals of Blocks with the same visibility,
+// built once per Chunk. The first visible Block below any depth is found
+// with a binary search instead of scanning down through air.
+class SurfaceIndex {
+ public:
+  enum { clsAir, clsLiquid, clsVisible };
+
+  explicit SurfaceIndex(const Chunk &chunk);
+
+  // highest y <= given y with a visible Block (optionally ignoring liquids),
+  // -4096 when there is none
+  int  findVisible(int offset, int y, bool skipLiquid) const;
+  bool isValid() const;  // Block definitions did not change since build
+  int  size() const;     // memory footprint in Bytes
+
+ private:
+  struct Interval {
+    short top;  // highest y of interval, it ends above top of the next one
+    short cls;
+  };
+
+  QVector<Interval> intervals;           // all columns, each column top->down
+  quint16           first[16 * 16 + 1];  // index of first Interval of each column
+  int               generation;
+};
+
+#endif  // SURFACEINDEX_H_
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+
+#include "fixture.h"
+#include "shading.h"
+#include "mapview.h"
+#include "clamp.h"
+
+// 8 bit alpha of the translucent Blocks in the definitions (0.25 .. 0.95)
+static const int translucent[] = {64, 71, 77, 102, 128, 135, 153, 158, 161, 179, 191, 204, 230, 242};
+static const int translucentCount = sizeof(translucent) / sizeof(*translucent);
+
+// small xorshift generator, the fixtures must not depend on the Qt version
+static quint32 nextRandom(quint32 &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// pre-calculated light spectrum for view mode "Biome Colors", as BiomeIdentifier does
+static void setBiomeColor(FixtureChunk &chunk, int offset, QRgb color) {
+  chunk.biomecolor[offset] = color;
+  const QColor biomecolor(color);
+  for (int i = 0; i < 16; i++) {
+    double light_factor = pow(0.90, 15-i);
+    chunk.biomecolors[offset][i].setRgb(light_factor*biomecolor.red(),
+                                        light_factor*biomecolor.green(),
+                                        light_factor*biomecolor.blue());
+  }
+}
+
+QVector<FixtureChunk> Fixture::chunks() {
+  QVector<FixtureChunk> result;
+  quint32 state = 0x2545f491;
+
+  // stacks of 0..15 translucent Blocks over an opaque ground,
+  // each row of columns with another alpha, light level changes along x
+  FixtureChunk corner;
+  corner.depth = 100;
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    const int x = offset & 0x0f;
+    const int z = offset >> 4;
+    setBiomeColor(corner, offset, qRgb(255, (x * 17) & 0xff, (z * 17) & 0xff));
+    corner.cave[offset] = (z & 1) ? 0xffff : (0x0101 << (x & 7));
+    for (int i = 0; i <= x; i++) {
+      FixtureBlock block;
+      const int alpha = (i == x) ? 255 : translucent[z % translucentCount];
+      const int level = (i * 73 + z * 31) & 0xff;
+      block.color = (z == 15) ? qRgba(255, 255, 255, alpha)
+                              : qRgba(level, 255 - level, (x * 16 + i) & 0xff, alpha);
+      block.y     = corner.depth - x - i;
+      block.light = (x + z + i) & 0x0f;
+      block.spawn = (i + z) & 0x07;
+      corner.blocks[offset].append(block);
+    }
+  }
+  result.append(corner);
+
+  // random columns, also with steps between neighbours for the edge highlight
+  for (int c = 0; c < 16; c++) {
+    FixtureChunk chunk;
+    chunk.depth = 64 + c;
+    for (int offset = 0; offset < 16 * 16; offset++) {
+      setBiomeColor(chunk, offset, nextRandom(state) | 0xff000000);
+      chunk.cave[offset] = nextRandom(state) & 0xffff;
+      int y = chunk.depth - nextRandom(state) % 8;
+      const int count = nextRandom(state) % 25;  // empty columns included
+      for (int i = 0; i < count; i++) {
+        FixtureBlock block;
+        const int alpha = (nextRandom(state) & 1) ? translucent[nextRandom(state) % translucentCount] : 255;
+        block.color = (nextRandom(state) & 0x00ffffff) | (alpha << 24);
+        block.y     = y;
+        block.light = nextRandom(state) & 0x0f;
+        block.spawn = ((nextRandom(state) & 3) == 0) ? (nextRandom(state) & 0x07) : 0;
+        chunk.blocks[offset].append(block);
+        y -= 1 + nextRandom(state) % 3;
+      }
+    }
+    result.append(chunk);
+  }
+  return result;
+}
+
+QSharedPointer<GBuffer> Fixture::scan(const FixtureChunk &chunk) {
+  QSharedPointer<GBuffer> gbuffer(new GBuffer());
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    gbuffer->first[offset] = gbuffer->samples.size();
+    quint32 alpha = 0;
+    int count = 0;
+    for (const FixtureBlock &block : chunk.blocks[offset]) {
+      GBuffer::Sample sample;
+      sample.color      = block.color;
+      sample.biomecolor = chunk.biomecolor[offset];
+      sample.y          = block.y;
+      sample.light      = block.light;
+      sample.spawn      = block.spawn;
+      gbuffer->samples.append(sample);
+      count++;
+
+      // same stop criterion as ChunkRenderer::scanKernel()
+      const quint32 blockalpha = qAlpha(block.color);
+      if (alpha == 0)
+        gbuffer->highest[offset] = block.y;
+      alpha = GBuffer::addAlpha(alpha, blockalpha);
+      if (blockalpha == 255 || alpha > GBuffer::ALPHA_SATURATED || count == GBuffer::MAX_LAYERS)
+        break;
+    }
+    if (count > 0)
+      gbuffer->cave[offset] = CaveShade::ONE - CaveShade::getShadeSum(chunk.cave[offset]);
+  }
+  gbuffer->first[16 * 16] = gbuffer->samples.size();
+  return gbuffer;
+}
+
+// formulas of ChunkRenderer::renderChunk() before the fixed point pipeline
+void Fixture::shadeReference(const FixtureChunk &chunk, int flags,
+                             uchar *image, short *depthmap) {
+  // cave shade curve was calculated once in floating point
+  static float caveshade[CaveShade::CAVE_DEPTH];
+  static bool  initialized = false;
+  if (!initialized) {
+    float cavesum = 0.0;
+    for (int i = 0; i < CaveShade::CAVE_DEPTH; i++) {
+      caveshade[i] = 1/exp(i/(CaveShade::CAVE_DEPTH/2.0));
+      cavesum += caveshade[i];
+    }
+    for (int i = 0; i < CaveShade::CAVE_DEPTH; i++)
+      caveshade[i] = 1.5 * caveshade[i] / cavesum;
+    initialized = true;
+  }
+
+  for (int offset = 0; offset < 16 * 16; offset++) {
+    const int x = offset & 0x0f;
+    const int lasty = (x > 0) ? depthmap[offset - 1] : -9999;
+
+    uchar r = 0, g = 0, b = 0;
+    double alpha = 0.0;
+    int highest = -4096;
+    for (const FixtureBlock &block : chunk.blocks[offset]) {
+      const double blockalpha = qAlpha(block.color) / 255.0;
+      const int y = block.y;
+
+      int light = block.light;
+      if (!(flags & MapView::flgLighting))
+        light = 13;
+      if ((alpha == 0.0) && (lasty != -9999)) {
+        if (lasty < y)
+          light += 2;
+        else if (lasty > y)
+          light -= 2;
+      }
+
+      double light_factor = pow(0.90, 15-light);
+      quint32 colr = std::clamp(int(light_factor*qRed(block.color)),   0, 255);
+      quint32 colg = std::clamp(int(light_factor*qGreen(block.color)), 0, 255);
+      quint32 colb = std::clamp(int(light_factor*qBlue(block.color)),  0, 255);
+
+      if (flags & MapView::flgDepthShading) {
+        static const quint32 shadeTable[] = {
+          0, 12, 18, 22, 24, 26, 28, 29, 30, 31, 32};
+        size_t idx = std::min(static_cast<size_t>(chunk.depth - y),
+                              sizeof(shadeTable) / sizeof(*shadeTable) - 1);
+        quint32 shade = shadeTable[idx];
+        colr = colr - std::min(shade, colr);
+        colg = colg - std::min(shade, colg);
+        colb = colb - std::min(shade, colb);
+      }
+
+      if (flags & MapView::flgMobSpawn) {
+        if (block.spawn & GBuffer::spawnOnTop) {
+          colr = (colr + 256) / 2;
+          colg = (colg + 0) / 2;
+          colb = (colb + 192) / 2;
+        }
+        if (block.spawn & GBuffer::spawnThrough) {
+          colr = (colr + 192) / 2;
+          colg = (colg + 0) / 2;
+          colb = (colb + 256) / 2;
+        }
+        if (block.spawn & GBuffer::spawnDrowned) {
+          colr = (colr + 256) / 2;
+          colg = (colg + 0) / 2;
+          colb = (colb + 128) / 2;
+        }
+      }
+
+      if (flags & MapView::flgBiomeColors) {
+        // the edge highlight used to read past the spectrum, clamped here
+        const QColor &color = chunk.biomecolors[offset][std::clamp(light, 0, 15)];
+        colr = color.red();
+        colg = color.green();
+        colb = color.blue();
+      }
+
+      if (alpha == 0.0) {
+        alpha = blockalpha;
+        r = colr;
+        g = colg;
+        b = colb;
+        highest = y;
+      } else {
+        r = (quint8)(alpha * r + (1.0 - alpha) * colr);
+        g = (quint8)(alpha * g + (1.0 - alpha) * colg);
+        b = (quint8)(alpha * b + (1.0 - alpha) * colb);
+        alpha += blockalpha * (1.0 - alpha);
+      }
+
+      if (blockalpha == 1.0 || alpha > 0.9)
+        break;
+    }
+
+    if ((flags & MapView::flgCaveMode) && (highest != -4096)) {
+      float cave_factor = 1.0;
+      for (int cave_test = 0; cave_test < CaveShade::CAVE_DEPTH; cave_test++) {
+        if (chunk.cave[offset] & (0x8000 >> cave_test))
+          cave_factor -= caveshade[cave_test];
+      }
+      cave_factor = std::max(cave_factor, 0.25f);
+      r = (quint8)(cave_factor * r);
+      g = (quint8)(cave_factor * g);
+      b = (quint8)(cave_factor * b);
+    }
+
+    depthmap[offset] = highest;
+    uchar *pixel = image + offset * 4;
+    pixel[0] = b;
+    pixel[1] = g;
+    pixel[2] = r;
+    pixel[3] = 0xff;
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef FIXTURE_H_
+#define FIXTURE_H_
+
+#include <QColor>
+#include <QSharedPointer>
+#include <QVector>
+#include "gbuffer.h"
+
+// one visible Block of a fixture column
+struct FixtureBlock {
+  QRgb   color;  // Biome tinted Block color, alpha channel is Block alpha
+  short  y;
+  quint8 light;  // Block light from one Block above
+  quint8 spawn;  // mob spawn detection bits
+};
+
+// Chunk sized set of columns, with all visible Blocks top->down
+struct FixtureChunk {
+  int                   depth;                // render depth
+  QRgb                  biomecolor[16 * 16];
+  QColor                biomecolors[16 * 16][16];  // light spectrum of Biome color,
+                                                   // like in BiomeInfo
+  QVector<FixtureBlock> blocks[16 * 16];
+  quint16               cave[16 * 16];        // transparent Blocks below the surface,
+                                              // bit 15 is the Block directly below
+};
+
+class Fixture {
+ public:
+  // deterministic fixture Chunks, the first one holds hand made corner cases
+  static QVector<FixtureChunk> chunks();
+
+  // collect color samples the way the scan of ChunkRenderer does
+  static QSharedPointer<GBuffer> scan(const FixtureChunk &chunk);
+
+  // floating point shading as it was done before the fixed point pipeline
+  static void shadeReference(const FixtureChunk &chunk, int flags,
+                             uchar *image, short *depthmap);
+};
+
+#endif  // FIXTURE_H_
@@ -0,0 +1,15 @@
+# shading code of Minutor together with fixture Chunks and the old
+# floating point shading as reference
+CONFIG += c++14 console
+CONFIG -= app_bundle
+QT += widgets concurrent testlib
+
+INCLUDEPATH += $$PWD/..
+HEADERS += \
+    $$PWD/../gbuffer.h \
+    $$PWD/../shading.h \
+    $$PWD/fixture.h
+SOURCES += \
+    $$PWD/../gbuffer.cpp \
+    $$PWD/../shading.cpp \
+    $$PWD/fixture.cpp
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+# Writes the fixture Chunks of the render test as gzipped NBT in the
+# 1.18 storage format. The output is deterministic, run it again only
+# when the fixtures change (and regenerate the golden images after that).
+import gzip
+import math
+import os
+import random
+import struct
+
+DATA_VERSION = 2860  # 1.18
+MIN_SECTION = -4
+MAX_SECTION = 7      # the fixtures stay below y=128
+
+
+# ---- NBT encoding -----------------------------------------------------------
+
+class Byte(int): pass
+class Int(int): pass
+class LongArray(list): pass
+class ByteArray(bytes): pass
+
+
+def tag_id(value):
+    if isinstance(value, Byte):      return 1
+    if isinstance(value, Int):       return 3
+    if isinstance(value, ByteArray): return 7
+    if isinstance(value, str):       return 8
+    if isinstance(value, LongArray): return 12
+    if isinstance(value, list):      return 9
+    if isinstance(value, dict):      return 10
+    raise TypeError(type(value))
+
+
+def payload(value):
+    if isinstance(value, Byte):
+        return struct.pack('>b', value)
+    if isinstance(value, Int):
+        return struct.pack('>i', value)
+    if isinstance(value, ByteArray):
+        return struct.pack('>i', len(value)) + bytes(value)
+    if isinstance(value, str):
+        raw = value.encode('utf-8')
+        return struct.pack('>H', len(raw)) + raw
+    if isinstance(value, LongArray):
+        return struct.pack('>i', len(value)) + b''.join(struct.pack('>q', v) for v in value)
+    if isinstance(value, list):
+        kind = tag_id(value[0]) if value else 0
+        return struct.pack('>bi', kind, len(value)) + b''.join(payload(v) for v in value)
+    if isinstance(value, dict):
+        out = b''
+        for name, child in value.items():
+            out += struct.pack('>b', tag_id(child)) + payload(name) + payload(child)
+        return out + b'\x00'
+    raise TypeError(type(value))
+
+
+def write_nbt(path, root):
+    raw = b'\x0a' + payload('') + payload(root)
+    with open(path, 'wb') as f:
+        f.write(gzip.compress(raw, mtime=0))
+
+
+# ---- packed arrays (1.16+ layout, entries never span two longs) ------------
+
+def pack(values, bits):
+    per_long = 64 // bits
+    longs = []
+    for i in range(0, len(values), per_long):
+        word = 0
+        for j, v in enumerate(values[i:i + per_long]):
+            word |= v << (j * bits)
+        if word >= 1 << 63:
+            word -= 1 << 64
+        longs.append(word)
+    return LongArray(longs)
+
+
+def palette_container(values, min_bits):
+    palette = []
+    index = {}
+    for v in values:
+        if v not in index:
+            index[v] = len(palette)
+            palette.append(v)
+    bits = max(min_bits, math.ceil(math.log2(len(palette))) if len(palette) > 1 else 0)
+    return palette, pack([index[v] for v in values], bits)
+
+
+# ---- Chunk assembly ---------------------------------------------------------
+
+class ChunkData:
+    def __init__(self, cx, cz):
+        self.cx, self.cz = cx, cz
+        self.blocks = {}  # (x, y, z) -> name, everything else is air
+        self.light  = {}  # (x, y, z) -> Block light 0..15
+        self.biomes = {}  # (x >> 2, y >> 2, z >> 2) -> Biome name
+
+    def set(self, x, y, z, name):
+        self.blocks[(x, y, z)] = name
+
+    def to_nbt(self):
+        sections = []
+        for sy in range(MIN_SECTION, MAX_SECTION + 1):
+            states = []
+            light = bytearray(2048)
+            for y in range(16):
+                for z in range(16):
+                    for x in range(16):
+                        pos = (x, sy * 16 + y, z)
+                        states.append(self.blocks.get(pos, 'minecraft:air'))
+                        level = self.light.get(pos, 0)
+                        i = (y << 8) | (z << 4) | x
+                        light[i >> 1] |= level << (4 * (i & 1))
+            palette, data = palette_container(states, 4)
+            block_states = {'palette': [{'Name': name} for name in palette]}
+            if len(palette) > 1:
+                block_states['data'] = data
+            cells = [self.biomes.get((x, sy * 4 + y, z), 'minecraft:plains')
+                     for y in range(4) for z in range(4) for x in range(4)]
+            biome_palette, biome_data = palette_container(cells, 1)
+            sections.append({
+                'Y': Byte(sy),
+                'block_states': block_states,
+                'biomes': {'palette': biome_palette, 'data': biome_data},
+                'BlockLight': ByteArray(light),
+            })
+        return {
+            'DataVersion': Int(DATA_VERSION),
+            'xPos': Int(self.cx),
+            'zPos': Int(self.cz),
+            'yPos': Int(MIN_SECTION),
+            'Status': 'full',
+            'sections': sections,
+        }
+
+
+# translucent Blocks of the definitions, ordered by alpha (0.25 .. 0.95)
+TRANSLUCENT = [
+    'minecraft:glass_pane',                  # 0.25
+    'minecraft:glass',                       # 0.28
+    'minecraft:vine',                        # 0.3
+    'minecraft:small_amethyst_bud',          # 0.4
+    'minecraft:white_stained_glass_pane',    # 0.5
+    'minecraft:water',                       # 0.53
+    'minecraft:large_amethyst_bud',          # 0.6
+    'minecraft:ice',                         # 0.62
+    'minecraft:frosted_ice',                 # 0.63
+    'minecraft:amethyst_cluster',            # 0.7
+    'minecraft:oak_fence',                   # 0.75
+    'minecraft:tinted_glass',                # 0.8
+    'minecraft:scaffolding',                 # 0.95
+]
+
+
+def stacks():
+    # stacks of 0..15 translucent Blocks over stone, each row another Block,
+    # so the saturation stop is hit with the alpha quantized from the definitions
+    chunk = ChunkData(0, 0)
+    for z in range(16):
+        for x in range(16):
+            ground = 80 - x
+            for y in range(-64, ground + 1):
+                chunk.set(x, y, z, 'minecraft:bedrock' if y == -64 else 'minecraft:stone')
+            # caves below the surface for Cave Mode
+            for y in range(ground - 16, ground):
+                if (y + x + z) % 3 == 0 or (z & 1 and y > ground - 6):
+                    del chunk.blocks[(x, y, z)]
+                    chunk.light[(x, y, z)] = (x + y) & 0x0f
+            if z < len(TRANSLUCENT):
+                for i in range(x):
+                    chunk.set(x, ground + 1 + i, z, TRANSLUCENT[z])
+            elif z == 13:
+                # water over a sea floor with plants, for Sea Ground
+                for i in range(x):
+                    chunk.set(x, ground + 1 + i, z, 'minecraft:kelp' if i == 0 and x & 1 else 'minecraft:water')
+            else:
+                chunk.set(x, ground, z, 'minecraft:grass_block')
+                if x & 1:
+                    chunk.set(x, ground + 1, z, 'minecraft:tall_grass')
+            for y in range(ground + 1, ground + 17):
+                chunk.light[(x, y, z)] = (x + z + y) & 0x0f
+    for z in range(4):
+        for x in range(4):
+            for y in range(-16, 32):
+                chunk.biomes[(x, y, z)] = ['minecraft:plains', 'minecraft:swamp',
+                                           'minecraft:jungle', 'minecraft:snowy_plains'][(x + z) & 3]
+    return chunk
+
+
+def terrain():
+    # random landscape: grass, trees, flowers, lakes with ice, caves with torches
+    rnd = random.Random(0x2545f491)
+    chunk = ChunkData(-1, 3)
+    biomes = ['minecraft:plains', 'minecraft:forest', 'minecraft:desert',
+              'minecraft:swamp', 'minecraft:ocean', 'minecraft:snowy_plains']
+    for key in [(x, y, z) for x in range(4) for y in range(-16, 32) for z in range(4)]:
+        chunk.biomes[key] = rnd.choice(biomes)
+    sea = 62
+    for z in range(16):
+        for x in range(16):
+            height = 56 + int(8 * math.sin(x / 3.0) + 6 * math.cos(z / 4.0)) + rnd.randrange(3)
+            for y in range(-64, height + 1):
+                if y == -64:
+                    name = 'minecraft:bedrock'
+                elif y < 0:
+                    name = 'minecraft:deepslate'
+                elif y < height - 3:
+                    name = 'minecraft:stone'
+                elif y < height:
+                    name = 'minecraft:dirt'
+                else:
+                    name = 'minecraft:sand' if height <= sea else 'minecraft:grass_block'
+                chunk.set(x, y, z, name)
+            for y in range(height + 1, sea + 1):
+                chunk.set(x, y, z, 'minecraft:ice' if y == sea and rnd.random() < 0.3 else 'minecraft:water')
+            if height > sea:
+                r = rnd.random()
+                if r < 0.1:
+                    chunk.set(x, height + 1, z, rnd.choice(['minecraft:dandelion', 'minecraft:poppy']))
+                elif r < 0.3:
+                    chunk.set(x, height + 1, z, 'minecraft:tall_grass')
+                elif r < 0.35:
+                    chunk.set(x, height + 1, z, 'minecraft:snow')
+            elif rnd.random() < 0.3:
+                chunk.set(x, height + 1, z, 'minecraft:seagrass')
+            for y in range(-63, height - 4):
+                if rnd.random() < 0.15:
+                    del chunk.blocks[(x, y, z)]
+                    if rnd.random() < 0.1:
+                        chunk.set(x, y, z, 'minecraft:torch')
+            for y in range(-64, 128):
+                if rnd.random() < 0.3:
+                    chunk.light[(x, y, z)] = rnd.randrange(16)
+    # a few trees, leaves may hang over columns of lower terrain
+    for tx, tz in [(3, 4), (11, 9), (6, 13)]:
+        top = max(y for (x, y, z) in chunk.blocks if x == tx and z == tz)
+        for y in range(top + 1, top + 6):
+            chunk.set(tx, y, tz, 'minecraft:oak_log')
+        for dx in range(-2, 3):
+            for dz in range(-2, 3):
+                for y in range(top + 4, top + 8):
+                    x, z = tx + dx, tz + dz
+                    if 0 <= x < 16 and 0 <= z < 16 and (x, y, z) not in chunk.blocks \
+                       and abs(dx) + abs(dz) + max(0, y - top - 6) < 4:
+                        chunk.set(x, y, z, 'minecraft:oak_leaves')
+    return chunk
+
+
+if __name__ == '__main__':
+    out = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'data')
+    os.makedirs(out, exist_ok=True)
+    write_nbt(os.path.join(out, 'stacks.nbt'),  stacks().to_nbt())
+    write_nbt(os.path.join(out, 'terrain.nbt'), terrain().to_nbt())
@@ -0,0 +1,21 @@
+# ChunkRenderer on fixture Chunks against golden images, rendering needs
+# most of Minutor, so all of it is built except main()
+TEMPLATE = app
+TARGET = tst_render
+CONFIG += testcase c++14 console
+CONFIG -= app_bundle
+QT += widgets network concurrent testlib
+unix:LIBS += -lz
+
+# taken from minutor.pro, so this also builds inside older trees
+MINUTOR = $$PWD/../..
+MINUTOR_SOURCES = $$fromfile($$MINUTOR/minutor.pro, SOURCES)
+MINUTOR_SOURCES -= main.cpp
+MINUTOR_HEADERS = $$fromfile($$MINUTOR/minutor.pro, HEADERS)
+MINUTOR_FORMS   = $$fromfile($$MINUTOR/minutor.pro, FORMS)
+for(file, MINUTOR_SOURCES): SOURCES += $$MINUTOR/$$file
+for(file, MINUTOR_HEADERS): HEADERS += $$MINUTOR/$$file
+for(file, MINUTOR_FORMS):   FORMS   += $$MINUTOR/$$file
+INCLUDEPATH += $$MINUTOR
+
+SOURCES += tst_render.cpp
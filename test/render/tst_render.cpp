@@ -0,0 +1,122 @@
+#include <QtTest>
+#include <QFile>
+#include <QImage>
+#include <QSharedPointer>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "chunk.h"
+#include "chunkrenderer.h"
+#include "json/json.h"
+#include "nbt/nbt.h"
+#include "identifier/blockidentifier.h"
+#include "identifier/biomeidentifier.h"
+
+// Golden image test of ChunkRenderer: the fixture Chunks in data/ (written by
+// make_chunks.py) are rendered with the vanilla definitions for all flag
+// combinations at two depths, and have to agree within +-1 per channel with
+// data/<name>.png rendered by the floating point renderer before the fixed
+// point pipeline.
+//
+// The test only uses interfaces that existed back then, so the golden images
+// are written by building this directory inside a checkout of that tree and
+// running it with MINUTOR_WRITE_GOLDEN=1.
+class TestRender : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void initTestCase();
+  void matchesGolden_data();
+  void matchesGolden();
+
+ private:
+  static const int FLAG_COMBINATIONS = 1 << 7;  // flgLighting .. flgSingleLayer
+
+  void loadDefinitions(const QString &name);
+  // one 16x16 tile per flag combination in a row, one row per depth
+  QImage render(const QString &name);
+};
+
+static const int depths[] = {319, 70};
+static const int depthCount = sizeof(depths) / sizeof(*depths);
+
+void TestRender::loadDefinitions(const QString &name) {
+  QFile f(QFINDTESTDATA("../../definitions/" + name));
+  QVERIFY2(f.open(QIODevice::ReadOnly), qPrintable(name));
+  std::unique_ptr<JSONData> def = JSON::parse(QString::fromUtf8(f.readAll()));
+  // same calls as DefinitionManager::loadDefinition()
+  if (def->at("type")->asString() == "flatblock")
+    BlockIdentifier::Instance().addDefinitions(dynamic_cast<JSONArray*>(def->at("data")));
+  else
+    BiomeIdentifier::Instance().addDefinitions(dynamic_cast<JSONArray*>(def->at("data")),
+                                               dynamic_cast<JSONArray*>(def->at("data18")));
+}
+
+void TestRender::initTestCase() {
+  loadDefinitions("vanilla_biomes.json");
+  loadDefinitions("vanilla_blocks.json");
+}
+
+void TestRender::matchesGolden_data() {
+  QTest::addColumn<QString>("name");
+
+  QTest::newRow("stacks")  << "stacks";   // translucent stacks, saturation stop
+  QTest::newRow("terrain") << "terrain";  // random landscape
+}
+
+QImage TestRender::render(const QString &name) {
+  const QString path = QFINDTESTDATA("data/" + name + ".nbt");
+  QImage image(16 * FLAG_COMBINATIONS, 16 * depthCount, QImage::Format_RGB32);
+  image.fill(Qt::magenta);
+
+  for (int d = 0; d < depthCount; d++) {
+    for (int flags = 0; flags < FLAG_COMBINATIONS; flags++) {
+      // fresh Chunk, nothing derived from an earlier render is kept
+      QSharedPointer<Chunk> chunk(new Chunk());
+      chunk->load(NBT(path));
+      ChunkRenderer renderer(chunk->getChunkX(), chunk->getChunkZ(), depths[d], flags);
+      renderer.renderChunk(chunk);
+
+      const uchar *bits = chunk->getImage();
+      for (int z = 0; z < 16; z++)
+        memcpy(image.scanLine(d * 16 + z) + flags * 16 * 4, bits + z * 16 * 4, 16 * 4);
+    }
+  }
+  return image;
+}
+
+void TestRender::matchesGolden() {
+  QFETCH(QString, name);
+
+  const QImage image = render(name);
+  const QString golden = QFileInfo(QFINDTESTDATA("data/" + name + ".nbt")).dir()
+                         .filePath(name + ".png");
+
+  if (qEnvironmentVariableIsSet("MINUTOR_WRITE_GOLDEN")) {
+    QVERIFY2(image.save(golden), qPrintable(golden));
+    return;
+  }
+  if (!QFile::exists(golden))
+    QSKIP("no golden image, write it with the renderer before the fixed point pipeline");
+
+  const QImage reference = QImage(golden).convertToFormat(QImage::Format_RGB32);
+  QCOMPARE(reference.size(), image.size());
+  for (int y = 0; y < image.height(); y++) {
+    const QRgb *line  = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+    const QRgb *gline = reinterpret_cast<const QRgb *>(reference.constScanLine(y));
+    for (int x = 0; x < image.width(); x++) {
+      const int diff = std::max({qAbs(qRed(line[x])   - qRed(gline[x])),
+                                 qAbs(qGreen(line[x]) - qGreen(gline[x])),
+                                 qAbs(qBlue(line[x])  - qBlue(gline[x]))});
+      QVERIFY2(diff <= 1,
+               qPrintable(QString("flags %1 depth %2 column %3: #%4 instead of #%5")
+                          .arg(x / 16).arg(depths[y / 16]).arg((y % 16) * 16 + x % 16)
+                          .arg(line[x] & 0xffffff, 6, 16, QChar('0'))
+                          .arg(gline[x] & 0xffffff, 6, 16, QChar('0'))));
+    }
+  }
+}
+
+QTEST_GUILESS_MAIN(TestRender)
+#include "tst_render.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_shading
+CONFIG += testcase
+include(../fixture.pri)
+
+SOURCES += tst_shading.cpp
@@ -0,0 +1,68 @@
+#include <QtTest>
+
+#include "fixture.h"
+#include "mapview.h"
+
+// Fixed point shading of GBuffer against the old floating point formulas on
+// synthetic color samples, both have to agree within +-1 per channel. The
+// scan and the definitions are covered by the golden images of test/render.
+class TestShading : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void initTestCase();
+  void matchesReference_data();
+  void matchesReference();
+
+ private:
+  QVector<FixtureChunk> chunks;
+};
+
+void TestShading::initTestCase() {
+  chunks = Fixture::chunks();
+}
+
+void TestShading::matchesReference_data() {
+  QTest::addColumn<int>("flags");
+
+  // all combinations of the flags used during shading
+  for (int flags = 0; flags < 32; flags++) {
+    QStringList names;
+    if (flags & MapView::flgLighting)     names << "Lighting";
+    if (flags & MapView::flgMobSpawn)     names << "MobSpawn";
+    if (flags & MapView::flgCaveMode)     names << "CaveMode";
+    if (flags & MapView::flgDepthShading) names << "DepthShading";
+    if (flags & MapView::flgBiomeColors)  names << "BiomeColors";
+    if (names.isEmpty())                  names << "plain";
+    QTest::newRow(qPrintable(names.join('+'))) << flags;
+  }
+}
+
+void TestShading::matchesReference() {
+  QFETCH(int, flags);
+
+  for (int c = 0; c < chunks.size(); c++) {
+    const FixtureChunk &chunk = chunks[c];
+    uchar image[16 * 16 * 4], reference[16 * 16 * 4];
+    short depthmap[16 * 16],  referenceDepth[16 * 16];
+
+    Fixture::scan(chunk)->shade(flags, chunk.depth, image, depthmap);
+    Fixture::shadeReference(chunk, flags, reference, referenceDepth);
+
+    for (int offset = 0; offset < 16 * 16; offset++) {
+      QVERIFY2(depthmap[offset] == referenceDepth[offset],
+               qPrintable(QString("Chunk %1 column %2: depth %3 instead of %4")
+                          .arg(c).arg(offset).arg(depthmap[offset]).arg(referenceDepth[offset])));
+      for (int channel = 0; channel < 4; channel++) {
+        const int diff = qAbs(int(image[offset * 4 + channel]) - int(reference[offset * 4 + channel]));
+        QVERIFY2(diff <= 1,
+                 qPrintable(QString("Chunk %1 column %2 channel %3: %4 instead of %5")
+                            .arg(c).arg(offset).arg(channel)
+                            .arg(image[offset * 4 + channel]).arg(reference[offset * 4 + channel])));
+      }
+    }
+  }
+}
+
+QTEST_GUILESS_MAIN(TestShading)
+#include "tst_shading.moc"
@@ -0,0 +1,70 @@
+#include <QtTest>
+
+#include "fixture.h"
+#include "mapview.h"
+
+// Throughput of shading all fixture Chunks with the fixed point GBuffer
+// kernels compared to the old floating point formulas.
+// Run with -tickcounter or -iterations N for stable numbers.
+class BenchShading : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void initTestCase();
+  void fixedPoint_data();
+  void fixedPoint();
+  void reference_data();
+  void reference();
+
+ private:
+  void addFlags();
+
+  QVector<FixtureChunk> chunks;
+  QVector<QSharedPointer<GBuffer>> gbuffers;
+};
+
+void BenchShading::initTestCase() {
+  chunks = Fixture::chunks();
+  for (const FixtureChunk &chunk : chunks)
+    gbuffers.append(Fixture::scan(chunk));
+}
+
+void BenchShading::addFlags() {
+  QTest::addColumn<int>("flags");
+  QTest::newRow("plain")    << 0;
+  QTest::newRow("Lighting") << int(MapView::flgLighting);
+  QTest::newRow("Lighting+DepthShading") << int(MapView::flgLighting | MapView::flgDepthShading);
+  QTest::newRow("all")      << int(MapView::flgLighting | MapView::flgMobSpawn | MapView::flgCaveMode |
+                                   MapView::flgDepthShading | MapView::flgBiomeColors);
+}
+
+void BenchShading::fixedPoint_data() {
+  addFlags();
+}
+
+void BenchShading::fixedPoint() {
+  QFETCH(int, flags);
+  uchar image[16 * 16 * 4];
+  short depthmap[16 * 16];
+  QBENCHMARK {
+    for (int c = 0; c < chunks.size(); c++)
+      gbuffers[c]->shade(flags, chunks[c].depth, image, depthmap);
+  }
+}
+
+void BenchShading::reference_data() {
+  addFlags();
+}
+
+void BenchShading::reference() {
+  QFETCH(int, flags);
+  uchar image[16 * 16 * 4];
+  short depthmap[16 * 16];
+  QBENCHMARK {
+    for (const FixtureChunk &chunk : chunks)
+      Fixture::shadeReference(chunk, flags, image, depthmap);
+  }
+}
+
+QTEST_GUILESS_MAIN(BenchShading)
+#include "bench_shading.moc"
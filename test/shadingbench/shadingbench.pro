@@ -0,0 +1,5 @@
+TEMPLATE = app
+TARGET = bench_shading
+include(../fixture.pri)
+
+SOURCES += bench_shading.cpp
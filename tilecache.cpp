@@ -0,0 +1,184 @@
+#include <algorithm>
+
+#include "tilecache.h"
+#include "tilestore.h"
+
+bool RenderedTile::isVisible(const OverlayItem &entity, int depth, const short *depthmap) {
+  // don't show entities above our depth
+  int entityY = entity.midpoint().y;
+  // everything below the current block,
+  // but also inside the current block
+  if (entityY >= depth + 1)
+    return false;
+  int entityX = static_cast<int>(entity.midpoint().x) & 0x0f;
+  int entityZ = static_cast<int>(entity.midpoint().z) & 0x0f;
+  int highY = depthmap[entityX + (entityZ << 4)];
+  return (entityY+10 >= highY) || (entityY+10 >= depth);
+}
+
+void RenderedTile::summarize(int depth) {
+  summary.clear();
+  for (auto it = entities.cbegin(); it != entities.cend(); ++it)
+    if (isVisible(**it, depth, this->depth))
+      summary[it.key()].add(**it);
+}
+
+TileCache::TileCache() {
+  // rendered Tiles are small compared to decoded Chunks,
+  // by default we keep 128MB of them
+  cache.setMaxCost((128 * 1024 * 1024) / sizeof(RenderedTile));
+  // G-buffers allow to switch shading flags without Chunk data,
+  // keep 64MB until the view tells how many are visible
+  gbuffers.setMaxCost(64 * 1024);
+}
+
+TileCache& TileCache::Instance() {
+  static TileCache singleton;
+  return singleton;
+}
+
+void TileCache::clear() {
+  QMutexLocker guard(&mutex);
+  cache.clear();
+  gbuffers.clear();
+  pending.clear();
+  missing.clear();
+}
+
+void TileCache::insert(const TileID &id, const Chunk &chunk, const QSharedPointer<GBuffer> &gbuffer) {
+  QSharedPointer<RenderedTile> *tile = new QSharedPointer<RenderedTile>(new RenderedTile());
+  memcpy((*tile)->image, chunk.image, sizeof(chunk.image));
+  memcpy((*tile)->depth, chunk.depth, sizeof(chunk.depth));
+  (*tile)->entities = chunk.entities;
+  (*tile)->hasEntities = true;
+  (*tile)->summarize(id.getDepth());
+  TileStore::Instance().store(id, **tile);
+
+  QMutexLocker guard(&mutex);
+  cache.insert(id, tile);
+  missing.remove(id);
+  if (gbuffer) {
+    TileID gid(id.getX(), id.getZ(), id.getDepth(), GBuffer::getScanFlags(id.getFlags()));
+    gbuffers.insert(gid, new QSharedPointer<GBuffer>(gbuffer), std::max(1, gbuffer->size() / 1024));
+  }
+}
+
+QSharedPointer<RenderedTile> TileCache::fetchCached(const TileID &id) {
+  QMutexLocker guard(&mutex);
+  QSharedPointer<RenderedTile> *tile = cache[id];
+  return tile ? *tile : QSharedPointer<RenderedTile>();
+}
+
+TileCache::ShadeState TileCache::requestShade(const TileID &id) {
+  QMutexLocker guard(&mutex);
+  if (pending.contains(id))
+    return ShadeState::pending;
+  // shading a scan of the same Blocks is preferred over a Tile from a previous session
+  TileID gid(id.getX(), id.getZ(), id.getDepth(), GBuffer::getScanFlags(id.getFlags()));
+  if (!gbuffers.contains(gid) &&
+      (missing.contains(id) || !TileStore::Instance().isEnabled()))
+    return ShadeState::render;
+  pending.insert(id);
+  return ShadeState::queue;
+}
+
+// re-shade a scan of the same Blocks, when only shading flags changed,
+// otherwise try to get the Tile from a previous session
+QSharedPointer<RenderedTile> TileCache::shade(const TileID &id) {
+  QSharedPointer<GBuffer> gbuffer;
+  {
+    QMutexLocker guard(&mutex);
+    if (!pending.contains(id))
+      return QSharedPointer<RenderedTile>();
+    TileID gid(id.getX(), id.getZ(), id.getDepth(), GBuffer::getScanFlags(id.getFlags()));
+    QSharedPointer<GBuffer> *entry = gbuffers[gid];
+    if (entry)
+      gbuffer = *entry;
+  }
+
+  QSharedPointer<RenderedTile> tile(new RenderedTile());
+  if (gbuffer) {
+    QSharedPointer<RenderedTile> west(fetchCached(TileID(id.getX() - 1, id.getZ(),
+                                                         id.getDepth(), id.getFlags())));
+    gbuffer->shade(id.getFlags(), id.getDepth(), tile->image, tile->depth,
+                   west ? west->depth : NULL);
+    tile->entities = gbuffer->entities;
+    tile->hasEntities = true;
+    tile->summarize(id.getDepth());
+    TileStore::Instance().store(id, *tile);
+  } else if (!TileStore::Instance().load(id, *tile)) {
+    // Chunk has to be rendered, the next request will not queue it here again
+    QMutexLocker guard(&mutex);
+    pending.remove(id);
+    missing.insert(id);
+    return QSharedPointer<RenderedTile>();
+  }
+
+  // pending until the Tile is available, so it is not queued twice
+  QMutexLocker guard(&mutex);
+  cache.insert(id, new QSharedPointer<RenderedTile>(tile));
+  pending.remove(id);
+  return tile;
+}
+
+void TileCache::cancelShade(const TileID &id) {
+  QMutexLocker guard(&mutex);
+  pending.remove(id);
+}
+
+bool TileCache::stitch(const TileID &id, const short *west) {
+  QSharedPointer<RenderedTile> tile;
+  QSharedPointer<GBuffer> gbuffer;
+  {
+    QMutexLocker guard(&mutex);
+    QSharedPointer<RenderedTile> *entry = cache[id];
+    TileID gid(id.getX(), id.getZ(), id.getDepth(), GBuffer::getScanFlags(id.getFlags()));
+    QSharedPointer<GBuffer> *gentry = gbuffers[gid];
+    if (!entry || !gentry)
+      return false;
+    tile = *entry;
+    gbuffer = *gentry;
+  }
+
+  // Tiles are shared with readers, replace by a stitched copy
+  QSharedPointer<RenderedTile> stitched(new RenderedTile(*tile));
+  gbuffer->shadeEdge(id.getFlags(), id.getDepth(), stitched->image, west);
+  TileStore::Instance().store(id, *stitched);
+
+  QMutexLocker guard(&mutex);
+  cache.insert(id, new QSharedPointer<RenderedTile>(stitched));
+  return true;
+}
+
+int TileCache::getCacheUsage() const {
+  QMutexLocker guard(&mutex);
+  return cache.totalCost();
+}
+
+int TileCache::getCacheMax() const {
+  QMutexLocker guard(&mutex);
+  return cache.maxCost();
+}
+
+void TileCache::setCacheMaxSize(int tiles) {
+  QMutexLocker guard(&mutex);
+  cache.setMaxCost(tiles);
+}
+
+void TileCache::setGBufferMaxSize(int chunks) {
+  QMutexLocker guard(&mutex);
+  // G-buffers differ in size with the number of translucent layers,
+  // use the average of those kept so far (8KB until then)
+  const int average = gbuffers.isEmpty() ? 8 : std::max(1, gbuffers.totalCost() / gbuffers.size());
+  gbuffers.setMaxCost(std::max(gbuffers.maxCost(), chunks * average));
+}
+
+int TileCache::getGBufferUsage() const {
+  QMutexLocker guard(&mutex);
+  return gbuffers.totalCost();
+}
+
+int TileCache::getGBufferMax() const {
+  QMutexLocker guard(&mutex);
+  return gbuffers.maxCost();
+}
@@ -0,0 +1,106 @@
+#ifndef TILECACHE_H_
+#define TILECACHE_H_
+
+#include <QCache>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include "chunk.h"
+#include "chunkid.h"
+#include "gbuffer.h"
+#include "overlay/entitycluster.h"
+
+// TileID is the key used to identify rendered Tiles
+// the same Chunk can be rendered with different depth and flags
+class TileID : public ChunkID {
+ public:
+  TileID(int cx, int cz, int depth, int flags);
+  bool operator==(const TileID &) const;
+  friend unsigned int qHash(const TileID &);
+
+  int getDepth() const { return depth; }
+  int getFlags() const { return flags; }
+
+ protected:
+  int depth, flags;
+};
+
+inline TileID::TileID(int cx, int cz, int depth, int flags)
+  : ChunkID(cx, cz), depth(depth), flags(flags) {
+}
+
+inline bool TileID::operator==(const TileID &other) const {
+  return ChunkID::operator==(other) && (other.depth == depth) && (other.flags == flags);
+}
+
+inline unsigned int qHash(const TileID &t) {
+  return qHash(static_cast<const ChunkID &>(t)) ^ (t.depth << 7) ^ t.flags;
+}
+
+
+// the result of rendering one Chunk, kept independent of the decoded Chunk data
+class RenderedTile {
+ public:
+  uchar  image[16 * 16 * 4];  // RGBA for 16*16 Blocks
+  short  depth[16 * 16];      // depth map of the rendered surface
+  Chunk::EntityMap entities;  // shared with Chunk, needed for the overlay
+  EntitySummary    summary;   // visible Entities per type, drawn at low zoom
+  bool   hasEntities;         // false when loaded from TileStore
+
+  RenderedTile() : hasEntities(false) {}
+
+  // Entities below the render depth are shown, unless buried too deep below the surface
+  static bool isVisible(const OverlayItem &entity, int depth, const short *depthmap);
+  // summarize the visible Entities once, instead of with every frame at low zoom
+  void summarize(int depth);
+};
+
+
+class TileCache {
+ public:
+  // singleton: access to global usable instance
+  static TileCache &Instance();
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  TileCache();
+  ~TileCache() {}
+  TileCache(const TileCache &);
+  TileCache &operator=(const TileCache &);
+
+ public:
+  enum class ShadeState {
+    render,   // Tile has to be rendered from Chunk data
+    queue,    // caller has to queue a ChunkRenderer, Tile is marked as pending
+    pending   // shading or loading is already queued
+  };
+
+  void clear();
+  // store rendered image of Chunk, and the G-buffer it was shaded from
+  void insert(const TileID &id, const Chunk &chunk,
+              const QSharedPointer<GBuffer> &gbuffer = QSharedPointer<GBuffer>());
+  QSharedPointer<RenderedTile> fetchCached(const TileID &id);  // only from memory
+  // shading of a G-buffer kept from a render with other shading flags, or
+  // loading of a Tile from TileStore, requested by the GUI thread and done by
+  // a ChunkRenderer, so the GUI thread never waits for disk access
+  ShadeState requestShade(const TileID &id);
+  QSharedPointer<RenderedTile> shade(const TileID &id);  // only pending Tiles
+  void cancelShade(const TileID &id);
+  // shade the first column of a Tile again with the depth map of the Tile to the
+  // west, fails when Tile or G-buffer are not in memory
+  bool stitch(const TileID &id, const short *west);
+  int  getCacheUsage() const;
+  int  getCacheMax() const;
+  void setCacheMaxSize(int tiles);
+  void setGBufferMaxSize(int chunks);  // never decreased, sized by the view
+  int  getGBufferUsage() const;  // in KB
+  int  getGBufferMax() const;    // in KB
+
+ private:
+  QCache<TileID, QSharedPointer<RenderedTile>> cache;
+  QCache<TileID, QSharedPointer<GBuffer>>      gbuffers;  // key uses GBuffer::getScanFlags()
+  QSet<TileID>                                 pending;   // queued for shading or loading
+  QSet<TileID>                                 missing;   // not in TileStore, until rendered
+  mutable QMutex mutex;
+};
+
+#endif  // TILECACHE_H_
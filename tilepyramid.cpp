@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "tilepyramid.h"
+
+TilePyramid::Region::Region()
+  : finest(LEVELS)
+{
+  std::fill_n(&present[0][0], LEVELS * 32, 0);
+}
+
+void TilePyramid::Region::allocate(int level) {
+  // coarser levels are averaged from finer ones, so start with whole pixels per Chunk
+  level = std::min(level, DIRECT_LEVELS - 1);
+  for (; finest > level; finest--) {
+    const int l = finest - 1;
+    levels[l] = QImage(512 >> l, 512 >> l, QImage::Format_RGB32);
+    if (l == 0) {
+      // same placeholder pattern as for missing Chunks
+      for (int y = 0; y < 512; y++) {
+        QRgb *line = reinterpret_cast<QRgb *>(levels[l].scanLine(y));
+        for (int x = 0; x < 512; x++)
+          line[x] = (((x & 8) ^ (y & 8)) == 0) ? 0xff444444 : 0xff888888;
+      }
+    } else {
+      levels[l].fill(0x666666);
+    }
+    std::fill_n(present[l], 32, 0);
+  }
+}
+
+int TilePyramid::Region::size() const {
+  int bytes = sizeof(Region);
+  for (int l = finest; l < LEVELS; l++)
+    bytes += (512 >> l) * (512 >> l) * 4;
+  return bytes;
+}
+
+
+TilePyramid::TilePyramid() {
+  // keep 128MB of Region images
+  regions.setMaxCost(128 * 1024);
+}
+
+int TilePyramid::getLevel(double zoom) {
+  if (zoom >= 1.0)
+    return 0;
+  return std::min(qRound(std::log2(1.0 / zoom)), LEVELS - 1);
+}
+
+void TilePyramid::clear() {
+  regions.clear();
+}
+
+void TilePyramid::insert(const TileID &id, const uchar *image, int level) {
+  // Regions grow when finer levels are needed, re-insert to update the cost
+  const TileID key(id.getX() >> 5, id.getZ() >> 5, id.getDepth(), id.getFlags());
+  Region *region = regions.take(key);
+  if (!region)
+    region = new Region();
+  region->allocate(level);
+  if (!regions.insert(key, region, std::max(1, region->size() / 1024)))
+    return;  // deleted by QCache
+
+  const int lx = id.getX() & 0x1f;
+  const int lz = id.getZ() & 0x1f;
+  for (int l = region->finest; l < LEVELS; l++) {
+    QImage &dst = region->levels[l];
+    if (l == 0) {
+      // atlas: copy scanlines of the Chunk image
+      for (int y = 0; y < 16; y++)
+        memcpy(dst.scanLine((lz << 4) + y) + (lx << 4) * 4, image + y * 16 * 4, 16 * 4);
+    } else if (l < DIRECT_LEVELS) {
+      // average blocks of the Chunk image (BGRA)
+      const int n     = 16 >> l;  // pixels per Chunk
+      const int block = 1 << l;   // Blocks per pixel
+      for (int y = 0; y < n; y++) {
+        QRgb *line = reinterpret_cast<QRgb *>(dst.scanLine(lz * n + y)) + lx * n;
+        for (int x = 0; x < n; x++) {
+          int r = 0, g = 0, b = 0;
+          for (int sy = 0; sy < block; sy++) {
+            const uchar *src = image + (((y * block + sy) * 16) + x * block) * 4;
+            for (int sx = 0; sx < block; sx++, src += 4) {
+              b += src[0];
+              g += src[1];
+              r += src[2];
+            }
+          }
+          const int count = block * block;
+          line[x] = qRgb(r / count, g / count, b / count);
+        }
+      }
+    } else {
+      // one pixel covers several Chunks, average 2x2 pixels of the finer level
+      const QImage &src = region->levels[l - 1];
+      const int x = (lx << 4) >> l;
+      const int y = (lz << 4) >> l;
+      const QRgb *line0 = reinterpret_cast<const QRgb *>(src.constScanLine(2 * y));
+      const QRgb *line1 = reinterpret_cast<const QRgb *>(src.constScanLine(2 * y + 1));
+      const QRgb p[4] = { line0[2 * x], line0[2 * x + 1], line1[2 * x], line1[2 * x + 1] };
+      reinterpret_cast<QRgb *>(dst.scanLine(y))[x] =
+          qRgb((qRed(p[0])   + qRed(p[1])   + qRed(p[2])   + qRed(p[3]))   / 4,
+               (qGreen(p[0]) + qGreen(p[1]) + qGreen(p[2]) + qGreen(p[3])) / 4,
+               (qBlue(p[0])  + qBlue(p[1])  + qBlue(p[2])  + qBlue(p[3]))  / 4);
+    }
+    region->present[l][lz] |= 1u << lx;
+  }
+}
+
+QImage TilePyramid::fetch(int rx, int rz, int depth, int flags, int level, quint32 *present) {
+  const TileID key(rx, rz, depth, flags);
+  Region *region = regions.object(key);
+  if (!region || (level < region->finest)) {
+    // Region grows, re-insert to update the cost
+    region = regions.take(key);
+    if (!region)
+      region = new Region();
+    region->allocate(level);
+    QImage image = region->levels[level];
+    std::copy_n(region->present[level], 32, present);
+    regions.insert(key, region, std::max(1, region->size() / 1024));
+    return image;
+  }
+  std::copy_n(region->present[level], 32, present);
+  return region->levels[level];  // implicitly shared
+}
+
+int TilePyramid::getUsage() const {
+  return regions.totalCost();
+}
+
+int TilePyramid::getMax() const {
+  return regions.maxCost();
+}
@@ -0,0 +1,48 @@
+#ifndef TILEPYRAMID_H_
+#define TILEPYRAMID_H_
+
+#include <QCache>
+#include <QImage>
+#include "tilecache.h"
+
+// Mipmapped images of whole Regions the view is composed from.
+// Level 0 is an atlas of all rendered Chunk images of a Region (512x512),
+// each further level halves that down to a single pixel per Region. All kept
+// levels are updated incrementally from the rendered Chunks they cover, so
+// the view can be drawn without fetching Tiles or Chunk data.
+class TilePyramid {
+ public:
+  static const int LEVELS = 10;        // 512x512 .. 1x1 pixels per Region
+  static const int DIRECT_LEVELS = 5;  // levels with at least 1 pixel per Chunk
+
+  TilePyramid();
+
+  // level matching a zoom factor, 0 when not zoomed out
+  static int getLevel(double zoom);
+
+  void clear();
+  // update all kept levels of the Region from the rendered image of one Chunk,
+  // levels down to the given one are kept from now on
+  void insert(const TileID &id, const uchar *image, int level);
+  // Region image at level, present gets one bit (x) per Chunk for each row (z)
+  // Chunks not present show a placeholder
+  QImage fetch(int rx, int rz, int depth, int flags, int level, quint32 *present);
+  int  getUsage() const;  // in KB
+  int  getMax() const;    // in KB
+
+ private:
+  class Region {
+   public:
+    Region();
+    void allocate(int level);  // keep all levels from given one upwards
+    int  size() const;         // memory footprint in Bytes
+
+    QImage  levels[LEVELS];
+    quint32 present[LEVELS][32];  // Chunks already contained in each level
+    int     finest;               // finest level kept
+  };
+
+  QCache<TileID, Region> regions;  // key uses Region coordinates
+};
+
+#endif  // TILEPYRAMID_H_
@@ -0,0 +1,234 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#include <algorithm>
+
+#include "tilestore.h"
+
+static const char    storeMagic[4]  = {'M', 'T', 'I', 'L'};
+static const quint32 storeVersion   = 1;
+static const int     maxOpenRegions = 64;
+
+TileStore::TileStore()
+  : definitionsHash(0)
+  , maxSize(0)
+  , usage(0)
+  , enabled(0)
+{
+  regions.setMaxCost(maxOpenRegions);
+}
+
+TileStore& TileStore::Instance() {
+  static TileStore singleton;
+  return singleton;
+}
+
+void TileStore::setPath(QString path, quint32 definitionsHash) {
+  QMutexLocker guard(&mutex);
+  regions.clear();
+  this->path = path;
+  this->definitionsHash = definitionsHash;
+  this->folder.clear();
+  enabled.store(0);
+
+  // optional feature, enabled by default
+  QSettings settings;
+  if (path.isEmpty() || !settings.value("disktilecache", true).toBool())
+    return;
+  maxSize = qint64(settings.value("disktilecachesize", 1024).toInt()) * 1024 * 1024;
+
+  // one folder per world dimension
+  QString key = QCryptographicHash::hash(QDir(path).absolutePath().toUtf8(),
+                                         QCryptographicHash::Sha1).toHex();
+  folder = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tiles/" + key;
+  if (!QDir().mkpath(folder))
+    folder.clear();
+  enabled.store(folder.isEmpty() ? 0 : 1);
+  // the size limit may have been lowered meanwhile
+  prune(maxSize);
+}
+
+void TileStore::clear() {
+  QMutexLocker guard(&mutex);
+  regions.clear();
+}
+
+TileStore::RegionTiles *TileStore::getRegion(const TileID &id, bool create) {
+  int rx = id.getX() >> 5;
+  int rz = id.getZ() >> 5;
+  TileID rid(rx, rz, id.getDepth(), id.getFlags());
+
+  RegionTiles *region = regions.object(rid);
+  if (region && !(create && region->missing))
+    return region;
+
+  // open (or create) file, failed attempts are also cached
+  region = new RegionTiles();
+  QString filename = folder + "/r." + QString::number(rx) + "." + QString::number(rz)
+                   + ".d" + QString::number(id.getDepth())
+                   + ".f" + QString::number(id.getFlags()) + ".tiles";
+  QString regionfilename = path + "/region/r." + QString::number(rx) + "." + QString::number(rz) + ".mca";
+  region->open(filename, regionfilename, definitionsHash, id.getDepth(), id.getFlags(), create);
+  regions.insert(rid, region);
+
+  if (region->created) {
+    usage += region->file.size();
+    if (usage > maxSize)
+      prune(maxSize * 3 / 4);  // leave some room, to not scan with every new file
+  }
+  return region;
+}
+
+// called with locked mutex
+void TileStore::prune(qint64 limit) {
+  // files in use are kept
+  QSet<QString> open;
+  for (const TileID &rid : regions.keys())
+    open.insert(QFileInfo(regions.object(rid)->file).absoluteFilePath());
+
+  const QString root = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tiles";
+  QList<QFileInfo> files;
+  usage = 0;
+  QDirIterator it(root, QStringList("*.tiles"), QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    it.next();
+    files.append(it.fileInfo());
+    usage += it.fileInfo().size();
+  }
+  if (usage <= limit)
+    return;
+
+  // oldest first, files are touched whenever they are opened
+  std::sort(files.begin(), files.end(), [](const QFileInfo &a, const QFileInfo &b) {
+    return a.lastModified() < b.lastModified();
+  });
+  for (const QFileInfo &info : files) {
+    if (usage <= limit)
+      break;
+    if (!open.contains(info.absoluteFilePath()) && QFile::remove(info.absoluteFilePath()))
+      usage -= info.size();
+  }
+}
+
+bool TileStore::load(const TileID &id, RenderedTile &tile) {
+  QMutexLocker guard(&mutex);
+  if (folder.isEmpty())
+    return false;
+
+  // a miss never creates a file
+  RegionTiles *region = getRegion(id, false);
+  if (!region->entries)
+    return false;
+
+  int idx = (id.getX() & 31) + (id.getZ() & 31) * 32;
+  const RegionTiles::Entry &entry = region->entries[idx];
+  // invalidate when Chunk was modified since rendering
+  if ((entry.timestamp == 0) || (entry.timestamp != region->timestamps[idx]))
+    return false;
+
+  memcpy(tile.image, entry.image, sizeof(tile.image));
+  memcpy(tile.depth, entry.depth, sizeof(tile.depth));
+  return true;
+}
+
+void TileStore::store(const TileID &id, const RenderedTile &tile) {
+  QMutexLocker guard(&mutex);
+  if (folder.isEmpty())
+    return;
+
+  RegionTiles *region = getRegion(id, true);
+  if (!region->entries)
+    return;
+
+  int idx = (id.getX() & 31) + (id.getZ() & 31) * 32;
+  if (region->timestamps[idx] == 0)
+    return;  // unknown Chunk age, never trust it later
+
+  RegionTiles::Entry &entry = region->entries[idx];
+  memcpy(entry.image, tile.image, sizeof(entry.image));
+  memcpy(entry.depth, tile.depth, sizeof(entry.depth));
+  entry.timestamp = region->timestamps[idx];
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// RegionTiles
+
+TileStore::RegionTiles::RegionTiles()
+  : data(NULL)
+  , entries(NULL)
+  , missing(false)
+  , created(false)
+{
+  memset(timestamps, 0, sizeof(timestamps));
+}
+
+TileStore::RegionTiles::~RegionTiles() {
+  if (data)
+    file.unmap(data);
+  file.close();
+}
+
+bool TileStore::RegionTiles::open(QString filename, QString regionfilename,
+                                  quint32 definitionsHash, int depth, int flags,
+                                  bool create) {
+  // read Chunk timestamps from second 4KB of Region header
+  QFile region(regionfilename);
+  if (!region.open(QIODevice::ReadOnly) || (region.size() < 8192))
+    return false;
+  uchar *header = region.map(4096, 4096);
+  if (!header)
+    return false;
+  for (int i = 0; i < 32 * 32; i++)
+    timestamps[i] = qFromBigEndian<quint32>(header + 4 * i);
+  region.unmap(header);
+  region.close();
+
+  // map tile file into memory
+  const qint64 size = sizeof(Header) + 32 * 32 * sizeof(Entry);
+  file.setFileName(filename);
+  if (!create && !file.exists()) {
+    missing = true;
+    return false;
+  }
+  if (!file.open(QIODevice::ReadWrite))
+    return false;
+  bool valid = (file.size() == size);
+  if (!valid) {
+    if (!create) {
+      missing = true;
+      return false;
+    }
+    if (!file.resize(size))
+      return false;
+    created = true;
+  }
+  // last use, for deletion of least recently used files
+  file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+  data = file.map(0, size);
+  if (!data)
+    return false;
+
+  // start from scratch when written for different definitions or format
+  Header *head = reinterpret_cast<Header*>(data);
+  if (!valid ||
+      (memcmp(head->magic, storeMagic, sizeof(storeMagic)) != 0) ||
+      (head->version != storeVersion) ||
+      (head->definitionsHash != definitionsHash) ||
+      (head->depth != depth) || (head->flags != flags)) {
+    memset(data, 0, size);
+    memcpy(head->magic, storeMagic, sizeof(storeMagic));
+    head->version = storeVersion;
+    head->definitionsHash = definitionsHash;
+    head->depth = depth;
+    head->flags = flags;
+  }
+  entries = reinterpret_cast<Entry*>(data + sizeof(Header));
+  return true;
+}
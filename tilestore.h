@@ -0,0 +1,82 @@
+#ifndef TILESTORE_H_
+#define TILESTORE_H_
+
+#include <QAtomicInt>
+#include <QCache>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include "tilecache.h"
+
+// Persistent storage of rendered Tiles across sessions.
+// One file per Region and render mode (depth + flags) in the user cache
+// directory. Each entry remembers the timestamp of the Chunk it was
+// rendered from, and is only used while the Region file still reports
+// the same timestamp for that Chunk. Files are only created when a Tile
+// is stored, the least recently used files of all worlds are deleted when
+// the store grows beyond its size limit.
+class TileStore {
+ public:
+  // singleton: access to global usable instance
+  static TileStore &Instance();
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  TileStore();
+  ~TileStore() {}
+  TileStore(const TileStore &);
+  TileStore &operator=(const TileStore &);
+
+ public:
+  void setPath(QString path, quint32 definitionsHash);  // world dimension folder, empty to disable
+  bool isEnabled() const { return enabled.load(); }      // without locking, no disk access
+  void clear();                                         // close all open files
+  bool load(const TileID &id, RenderedTile &tile);
+  void store(const TileID &id, const RenderedTile &tile);
+
+ private:
+  // one memory mapped file per Region and render mode
+  class RegionTiles {
+   public:
+    RegionTiles();
+    ~RegionTiles();
+    // without create a missing file is not created, but flagged as missing
+    bool open(QString filename, QString regionfilename, quint32 definitionsHash, int depth, int flags,
+              bool create);
+
+    struct Header {
+      char    magic[4];
+      quint32 version;
+      quint32 definitionsHash;
+      qint32  depth;
+      qint32  flags;
+      quint32 reserved[3];
+    };
+    struct Entry {
+      quint32 timestamp;          // timestamp of Chunk when rendered, 0 = empty
+      quint32 reserved;
+      uchar   image[16 * 16 * 4];
+      short   depth[16 * 16];
+    };
+
+    QFile   file;
+    uchar  *data;
+    Entry  *entries;
+    bool    missing;   // file did not exist yet
+    bool    created;   // file was created (or resized) by open()
+    quint32 timestamps[32 * 32];  // current Chunk timestamps from Region header
+  };
+
+  RegionTiles *getRegion(const TileID &id, bool create);
+  void prune(qint64 limit);  // delete least recently used files down to limit
+
+  QString path;
+  QString folder;
+  quint32 definitionsHash;
+  qint64  maxSize;  // in Bytes, for the files of all worlds together
+  qint64  usage;    // in Bytes
+  QAtomicInt enabled;  // folder is available
+  QCache<TileID, RegionTiles> regions;  // open files, key uses Region coordinates
+  QMutex  mutex;
+};
+
+#endif  // TILESTORE_H_
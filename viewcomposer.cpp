@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "viewcomposer.h"
+#include "chunkcache.h"
+#include "tilecache.h"
+#include "tilepyramid.h"
+
+int ViewState::getLevel() const {
+  return TilePyramid::getLevel(zoom);
+}
+
+QRect ViewState::getChunksIn(const QRect &area) const {
+  const double left   = x + (area.left()       - size.width()  / 2) / zoom;
+  const double top    = z + (area.top()        - size.height() / 2) / zoom;
+  const double right  = x + (area.right()  + 1 - size.width()  / 2) / zoom;
+  const double bottom = z + (area.bottom() + 1 - size.height() / 2) / zoom;
+  return QRect(QPoint(floor(left  / 16), floor(top    / 16)),
+               QPoint(floor(right / 16), floor(bottom / 16)));
+}
+
+QRectF ViewState::getScreenRect(int bx, int bz, int size) const {
+  return QRectF(this->size.width()  / 2 + (bx - x) * zoom,
+                this->size.height() / 2 + (bz - z) * zoom,
+                size * zoom, size * zoom);
+}
+
+
+ViewComposer::ViewComposer(const ViewState &state)
+  : state(state)
+  , hasBase(false)
+  , reused(false)
+  , clustered(false)
+  , cellBits(0)
+{
+  // result is picked up by the view before deletion
+  setAutoDelete(false);
+}
+
+void ViewComposer::setBase(const ViewState &state, const QImage &chunks, const QImage &overlays,
+                           const QRegion &dirty) {
+  baseState     = state;
+  hasBase       = true;
+  imageChunks   = chunks;
+  imageOverlays = overlays;
+  this->dirty   = dirty;
+}
+
+void ViewComposer::setRegions(const QHash<ChunkID, QImage> &regions) {
+  this->regions = regions;
+}
+
+void ViewComposer::setOverlays(const QSet<QString> &types, const OverlayMap &items,
+                               const OverlayIndex &searchResults) {
+  overlayItemTypes    = types;
+  overlayItems        = items;
+  this->searchResults = searchResults;
+}
+
+void ViewComposer::setEntitySummaries(const QHash<ChunkID, EntitySummary> &summaries) {
+  entitySummaries = summaries;
+}
+
+void ViewComposer::run() {
+  const QRect view(QPoint(0, 0), state.size);
+
+  // the previous frame is reused when it only has to be shifted
+  int dx = 0, dy = 0;
+  bool reuse = hasBase &&
+               (baseState.generation == state.generation) &&
+               (baseState.size == state.size) &&
+               (baseState.zoom == state.zoom);
+  if (reuse) {
+    dx = qRound((state.x - baseState.x) * state.zoom);
+    dy = qRound((state.z - baseState.z) * state.zoom);
+    reuse = (qAbs(dx) < state.size.width()) && (qAbs(dy) < state.size.height());
+  }
+
+  // at low zoom Entities are aggregated for the whole view at once
+  clustered = !overlayItemTypes.isEmpty() && (16 * state.zoom < DETAIL_PIXELS);
+  if (clustered)
+    buildClusters();
+
+  QRegion areas;
+  if (reuse) {
+    if (dx || dy) {
+      scrollImage(imageChunks,   -dx, -dy);
+      scrollImage(imageOverlays, -dx, -dy);
+    }
+    // exposed strips
+    const int width  = state.size.width();
+    const int height = state.size.height();
+    if (dx > 0) areas += QRect(width - dx, 0, dx, height);
+    if (dx < 0) areas += QRect(0, 0, -dx, height);
+    if (dy > 0) areas += QRect(0, height - dy, width, dy);
+    if (dy < 0) areas += QRect(0, 0, width, -dy);
+    // updated Chunks
+    for (const QRect &chunks : dirty.rects()) {
+      areas += state.getScreenRect(chunks.left() * 16, chunks.top() * 16, 16)
+                 .united(state.getScreenRect(chunks.right() * 16, chunks.bottom() * 16, 16))
+                 .toAlignedRect() & view;
+      // the marker of the whole cell may move
+      if (clustered)
+        areas += getClusterArea(QRect(QPoint(chunks.left()  >> cellBits, chunks.top()    >> cellBits),
+                                      QPoint(chunks.right() >> cellBits, chunks.bottom() >> cellBits)))
+                 & view;
+    }
+  } else {
+    imageChunks   = QImage(state.size, QImage::Format_RGB32);
+    imageOverlays = QImage(state.size, QImage::Format_RGBA8888);
+    areas = view;
+  }
+
+  for (const QRect &area : areas.rects()) {
+    composeRegions(area);
+    drawOverlays(area);
+  }
+  reused   = reuse;
+  shift    = QPoint(dx, dy);
+  composed = areas;
+
+  emit composed();
+}
+
+// compose an area of the view from the Region atlas images, a handful of blits
+void ViewComposer::composeRegions(const QRect &area) {
+  const QRect chunks = state.getChunksIn(area);
+  const int level = state.getLevel();
+  const double scale = state.zoom * (1 << level);  // screen pixels per atlas pixel
+
+  QPainter canvas(&imageChunks);
+  if (scale < 1.0)
+    canvas.setRenderHint(QPainter::SmoothPixmapTransform);
+  for (int rz = chunks.top() >> 5; rz <= chunks.bottom() >> 5; rz++) {
+    for (int rx = chunks.left() >> 5; rx <= chunks.right() >> 5; rx++) {
+      QRectF targetRect(state.getScreenRect(rx * 512, rz * 512, 512));
+      QRectF clipped = targetRect & QRectF(area);
+      if (clipped.isEmpty()) continue;
+      auto region = regions.constFind(ChunkID(rx, rz));
+      if (region == regions.constEnd()) continue;
+      QRectF sourceRect((clipped.left() - targetRect.left()) / scale,
+                        (clipped.top()  - targetRect.top())  / scale,
+                        clipped.width() / scale, clipped.height() / scale);
+      canvas.drawImage(clipped, *region, sourceRect);
+    }
+  }
+}
+
+// draw Entities, Structures and search results inside an area of the view
+void ViewComposer::drawOverlays(const QRect &area) {
+  QPainter canvas(&imageOverlays);
+  canvas.setClipRect(area);
+  // clear the overlay layer
+  canvas.setCompositionMode(QPainter::CompositionMode_Source);
+  canvas.fillRect(area, Qt::transparent);
+  canvas.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+  const double zoom = state.zoom;
+  const int depth   = state.depth;
+
+  // add on the entity layer
+  double halfviewwidth  = state.size.width() / 2 / zoom;
+  double halvviewheight = state.size.height() / 2 / zoom;
+  double x1 = state.x - halfviewwidth;
+  double z1 = state.z - halvviewheight;
+
+  if (clustered)
+    drawEntityClusters(area, x1, z1, canvas);
+  else if (!overlayItemTypes.isEmpty())
+    drawEntities(area, x1, z1, canvas);
+
+  // Chunks around the area, as overlay items extend beyond their position
+  const QRect chunks = state.getChunksIn(area).adjusted(-1, -1, 1, 1);
+  int startx = chunks.left();
+  int startz = chunks.top();
+  int blockswide = chunks.width();
+  int blockstall = chunks.height();
+
+  const OverlayItem::Cuboid viewingCuboid(OverlayItem::Point(startx * 16, -4096, startz * 16),
+                                          OverlayItem::Point((startx + blockswide) * 16, depth,
+                                                             (startz + blockstall) * 16));
+
+  // draw the generated structures
+  for (auto &type : overlayItemTypes) {
+    drawOverlayItems(overlayItems.value(type), viewingCuboid, x1, z1, canvas);
+  }
+
+  drawOverlayItems(searchResults, viewingCuboid, x1, z1, canvas);
+}
+
+// draw single Entities, only from already loaded Chunks
+void ViewComposer::drawEntities(const QRect &area, double x1, double z1, QPainter &canvas) {
+  const double zoom = state.zoom;
+  const int depth   = state.depth;
+  const int margin  = EntityCluster::RADIUS + 1;
+  const QRectF culling(area);
+
+  // Chunks around the area, as Entities extend beyond their position
+  const QRect chunks = state.getChunksIn(area).adjusted(-1, -1, 1, 1);
+  TileCache  &tiles = TileCache::Instance();
+  ChunkCache &cache = ChunkCache::Instance();
+  for (int cz = chunks.top(); cz <= chunks.bottom(); cz++) {
+    for (int cx = chunks.left(); cx <= chunks.right(); cx++) {
+      // only what is in memory already, use rendered Tile if available
+      const Chunk::EntityMap *entities = NULL;
+      const short *depthmap = NULL;
+      QSharedPointer<RenderedTile> tile(tiles.fetchCached(TileID(cx, cz, depth, state.flags)));
+      QSharedPointer<Chunk> chunk;
+      if (tile && tile->hasEntities) {
+        entities = &tile->entities;
+        depthmap = tile->depth;
+      } else if ((cache.getCached(ChunkID(cx, cz), chunk) == CacheState::cached) &&
+                 chunk && chunk->loaded) {
+        // Chunks still being loaded are filled by the loader thread meanwhile
+        entities = &chunk->getEntityMap();
+        depthmap = chunk->depth;
+      }
+      if (!entities)
+        continue;
+
+      for (auto &type : overlayItemTypes) {
+        auto range = entities->equal_range(type);
+        for (auto it = range.first; it != range.second; ++it) {
+          // skip everything not reaching into the area
+          const OverlayItem::Cuboid box = (*it)->bounds();
+          const QRectF screen(QPointF((box.min.x - x1) * zoom, (box.min.z - z1) * zoom),
+                              QPointF((box.max.x - x1) * zoom, (box.max.z - z1) * zoom));
+          if (!screen.adjusted(-margin, -margin, margin, margin).intersects(culling))
+            continue;
+          // same rule as for the summaries drawn as clusters
+          if (RenderedTile::isVisible(**it, depth, depthmap))
+            (*it)->draw(x1, z1, zoom, &canvas);
+        }
+      }
+    }
+  }
+}
+
+// draw one marker per cell with Entities, the markers reaching into the area
+void ViewComposer::drawEntityClusters(const QRect &area, double x1, double z1, QPainter &canvas) {
+  const int margin = EntityCluster::RADIUS + 1;
+  const QRect chunks = state.getChunksIn(area.adjusted(-margin, -margin, margin, margin));
+  for (int cz = chunks.top() >> cellBits; cz <= chunks.bottom() >> cellBits; cz++) {
+    for (int cx = chunks.left() >> cellBits; cx <= chunks.right() >> cellBits; cx++) {
+      auto cluster = clusters.constFind(ChunkID(cx, cz));
+      if (cluster != clusters.constEnd())
+        cluster->draw(x1, z1, state.zoom, &canvas);
+    }
+  }
+}
+
+// aggregate the Entities around the view into cells of at least CLUSTER_PIXELS,
+// cells are aligned to the world, so markers stay in place while panning
+void ViewComposer::buildClusters() {
+  cellBits = 0;
+  while ((16 << cellBits) * state.zoom < CLUSTER_PIXELS)
+    cellBits++;
+
+  const int margin = EntityCluster::RADIUS + 1;
+  const QRect chunks = state.getChunksIn(QRect(QPoint(0, 0), state.size)
+                                           .adjusted(-margin, -margin, margin, margin));
+  const QRect cells(QPoint(chunks.left()  >> cellBits, chunks.top()    >> cellBits),
+                    QPoint(chunks.right() >> cellBits, chunks.bottom() >> cellBits));
+
+  // each type on its own first, the most frequent one gives the color
+  // (summaries only contain Entities visible at the depth of the view)
+  QHash<ChunkID, EntitySummary> cellTypes;
+  auto collect = [&](const ChunkID &cell, const EntitySummary &summary) {
+    for (auto &type : overlayItemTypes) {
+      auto it = summary.constFind(type);
+      if (it != summary.constEnd())
+        cellTypes[cell][type].add(*it);
+    }
+  };
+  const qint64 covered = (qint64(cells.width()) * cells.height()) << (2 * cellBits);
+  if (covered > entitySummaries.size()) {
+    // zoomed out, fewer Chunks with Entities than Chunks covered
+    for (auto it = entitySummaries.constBegin(); it != entitySummaries.constEnd(); ++it) {
+      const ChunkID cell(it.key().getX() >> cellBits, it.key().getZ() >> cellBits);
+      if (cells.contains(cell.getX(), cell.getZ()))
+        collect(cell, *it);
+    }
+  } else {
+    for (int cz = cells.top() << cellBits; cz < (cells.bottom() + 1) << cellBits; cz++) {
+      for (int cx = cells.left() << cellBits; cx < (cells.right() + 1) << cellBits; cx++) {
+        auto it = entitySummaries.constFind(ChunkID(cx, cz));
+        if (it != entitySummaries.constEnd())
+          collect(ChunkID(cx >> cellBits, cz >> cellBits), *it);
+      }
+    }
+  }
+
+  clusters.clear();
+  for (auto cell = cellTypes.constBegin(); cell != cellTypes.constEnd(); ++cell) {
+    EntityCluster cluster;
+    for (const EntityCluster &type : *cell)
+      cluster.add(type);
+    if (cluster.getCount() > 0)
+      clusters.insert(cell.key(), cluster);
+  }
+}
+
+QRect ViewComposer::getClusterArea(const QRect &cells) const {
+  const int size   = 16 << cellBits;
+  const int margin = EntityCluster::RADIUS + 1;
+  return state.getScreenRect(cells.left() * size, cells.top() * size, size)
+           .united(state.getScreenRect(cells.right() * size, cells.bottom() * size, size))
+           .toAlignedRect().adjusted(-margin, -margin, margin, margin);
+}
+
+void ViewComposer::drawOverlayItems(const OverlayIndex &index, const OverlayItem::Cuboid &cuboid,
+                                    double x1, double z1, QPainter &canvas) {
+  for (auto &item : index.query(cuboid)) {
+    item->draw(x1, z1, state.zoom, &canvas);
+  }
+}
+
+// shift image contents by a pixel delta, the exposed part is left as is
+void ViewComposer::scrollImage(QImage &image, int dx, int dy) {
+  const int bpl    = image.bytesPerLine();
+  const int pixel  = image.depth() / 8;
+  const int width  = image.width()  - qAbs(dx);
+  const int height = image.height() - qAbs(dy);
+  if ((width <= 0) || (height <= 0))
+    return;
+
+  const int srcX = std::max(-dx, 0) * pixel;
+  const int dstX = std::max( dx, 0) * pixel;
+  uchar *bits = image.bits();
+  if (dy > 0) {
+    // move down, start at the bottom
+    for (int y = height - 1; y >= 0; y--)
+      memmove(bits + (y + dy) * bpl + dstX, bits + y * bpl + srcX, width * pixel);
+  } else {
+    for (int y = 0; y < height; y++)
+      memmove(bits + y * bpl + dstX, bits + (y - dy) * bpl + srcX, width * pixel);
+  }
+}
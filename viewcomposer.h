@@ -0,0 +1,104 @@
+#ifndef VIEWCOMPOSER_H_
+#define VIEWCOMPOSER_H_
+
+#include <QObject>
+#include <QRunnable>
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QRegion>
+#include <QSet>
+#include <QSharedPointer>
+#include <QVector>
+#include "chunkid.h"
+#include "overlay/entitycluster.h"
+#include "overlay/overlayindex.h"
+#include "overlay/overlayitem.h"
+
+// position and settings a frame of the view is composed for
+struct ViewState {
+  double x, z;      // Block at the center of the view
+  double zoom;
+  int    depth;
+  int    flags;
+  QSize  size;      // in pixels
+  int    generation;  // changes whenever content drawn so far becomes invalid
+
+  int    getLevel() const;
+  // Chunks (at least partially) inside an area of the view, in Chunk coordinates
+  QRect  getChunksIn(const QRect &area) const;
+  // area on screen covered by a square of Blocks
+  QRectF getScreenRect(int bx, int bz, int size) const;
+};
+
+// composes a finished frame (Chunk layer and overlay layer) off the GUI thread
+// from the Region images of the TilePyramid and the overlay items,
+// a previous frame is reused by shifting it when only the position changed
+class ViewComposer : public QObject, public QRunnable {
+  Q_OBJECT
+
+ public:
+  typedef QHash<QString, OverlayIndex> OverlayMap;
+
+  explicit ViewComposer(const ViewState &state);
+
+  // previous frame to start from, Chunks in dirty have to be composed again
+  void setBase(const ViewState &state, const QImage &chunks, const QImage &overlays,
+               const QRegion &dirty);
+  // Region images at the level of the view, keyed by Region coordinates
+  void setRegions(const QHash<ChunkID, QImage> &regions);
+  void setOverlays(const QSet<QString> &types, const OverlayMap &items,
+                   const OverlayIndex &searchResults);
+  // visible Entities of each rendered Chunk aggregated per type, for drawing at low zoom
+  void setEntitySummaries(const QHash<ChunkID, EntitySummary> &summaries);
+
+  const ViewState &getState() const    { return state; }
+  const QImage    &getChunks() const   { return imageChunks; }
+  const QImage    &getOverlays() const { return imageOverlays; }
+  // the base frame was reused: shifted by getShift() pixels, with getComposed() drawn anew
+  bool  isIncremental() const          { return reused; }
+  const ViewState &getBaseState() const { return baseState; }
+  QPoint getShift() const               { return shift; }
+  const QRegion &getComposed() const    { return composed; }
+
+ signals:
+  void composed();
+
+ protected:
+  void run();
+
+ private:
+  static const int DETAIL_PIXELS  = 16;  // smaller Chunks on screen show Entity clusters
+  static const int CLUSTER_PIXELS = 32;  // minimal size of a cluster cell on screen
+
+  void composeRegions(const QRect &area);
+  void drawOverlays(const QRect &area);
+  void drawEntities(const QRect &area, double x1, double z1, QPainter &canvas);
+  void drawEntityClusters(const QRect &area, double x1, double z1, QPainter &canvas);
+  void buildClusters();
+  // screen area of cluster cells, including markers extending beyond them
+  QRect getClusterArea(const QRect &cells) const;
+  void drawOverlayItems(const OverlayIndex &index, const OverlayItem::Cuboid &cuboid,
+                        double x1, double z1, QPainter &canvas);
+  static void scrollImage(QImage &image, int dx, int dy);
+
+  ViewState state;
+  ViewState baseState;
+  bool      hasBase;
+  bool      reused;
+  QPoint    shift;
+  QRegion   composed;  // areas of the view drawn anew
+  QRegion   dirty;  // in Chunk coordinates
+  QImage    imageChunks;
+  QImage    imageOverlays;
+  QHash<ChunkID, QImage> regions;
+  QSet<QString> overlayItemTypes;
+  OverlayMap    overlayItems;
+  OverlayIndex  searchResults;
+  QHash<ChunkID, EntitySummary> entitySummaries;
+  bool clustered;   // Entities drawn as clusters of cells
+  int  cellBits;    // a cell covers 2^cellBits x 2^cellBits Chunks
+  QHash<ChunkID, EntityCluster> clusters;  // keyed by cell
+};
+
+#endif  // VIEWCOMPOSER_H_
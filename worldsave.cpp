@@ -8,6 +8,7 @@
  */
 
 #include <zlib.h>
+#include <QThread>
 #include "worldsave.h"
 #include "mapview.h"
 #include "chunkloader.h"
@@ -53,6 +54,9 @@ static void writeChunk(QFile *f, const char *tag, const char *data,
 }
 
 void WorldSave::run() {
+  // leave the cores to the renders for the view
+  QThread::currentThread()->setPriority(QThread::LowPriority);
+
   emit progress(tr("Calculating world bounds"), 0.0);
   QString path = map->getWorldPath();
 
@@ -105,6 +109,8 @@ void WorldSave::run() {
   double maximum = (bottom + 1 - top) * (right + 1 - left);
   double step = 0.0;
   for (int cz = top; cz <= bottom; cz++) {
+    // edge highlight continues from the Chunk to the west
+    QSharedPointer<GBuffer> west;
     for (int cx = left; cx <= right; cx++, step += 1.0) {
       emit progress(tr("Rendering world"), step / maximum);
 
@@ -112,9 +118,10 @@ void WorldSave::run() {
       QSharedPointer<Chunk> chunk(new Chunk());
 
       if (ChunkLoader::loadNbt(path, cx, cz, chunk)) {
-        drawChunk(scanlines, width * 4 + 1, cx - left, chunk);
+        west = drawChunk(scanlines, width * 4 + 1, cx - left, chunk, west);
       } else {
         blankChunk(scanlines, width * 4 + 1, cx - left);
+        west.reset();
       }
       // cleanup memory resources
       chunk.reset();
@@ -265,7 +272,8 @@ void WorldSave::blankChunk(uchar *scanlines, int stride, int x) {
     memset(scanlines + offset, 0, 16 * 4);
 }
 
-void WorldSave::drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk) {
+QSharedPointer<GBuffer> WorldSave::drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk,
+                                             const QSharedPointer<GBuffer> &west) {
   // calculate attenuation
   float attenuation = 1.0f;
   if (this->regionChecker && static_cast<int>(floor(chunk->getChunkX() / 32.0f) +
@@ -276,7 +284,7 @@ void WorldSave::drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Ch
 
   // render chunk with current settings
   ChunkRenderer renderer(chunk->getChunkX(), chunk->getChunkZ(), map->getDepth(), map->getFlags());
-  renderer.renderChunk(chunk);
+  QSharedPointer<GBuffer> gbuffer = renderer.renderChunk(chunk, west ? west->highest : NULL);
   // we can't memcpy each scanline because it's in BGRA format.
   int offset = x * 16 * 4 + 1;
   int ioffset = 0;
@@ -289,4 +297,5 @@ void WorldSave::drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Ch
       scanlines[xofs+3] = attenuation * chunk->getImage()[ioffset++];
     }
   }
+  return gbuffer;
 }
@@ -4,9 +4,11 @@
 
 #include <QObject>
 #include <QRunnable>
+#include <QSharedPointer>
 
 class MapView;
 class Chunk;
+class GBuffer;
 
 class WorldSave : public QObject, public QRunnable {
   Q_OBJECT
@@ -25,7 +27,9 @@ class WorldSave : public QObject, public QRunnable {
 
  private:
   void blankChunk(uchar *scanlines, int stride, int x);
-  void drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk);
+  // west is the rendered Chunk to the west, returns the rendered Chunk
+  QSharedPointer<GBuffer> drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk,
+                                    const QSharedPointer<GBuffer> &west);
 
   QString filename;
   MapView *map;